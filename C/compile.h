@@ -0,0 +1,140 @@
+#ifndef AULE_COMPILE_H
+#define AULE_COMPILE_H
+
+// GLSL to SPIR-V in process, with shaderc when built with SHADERC=1. The
+// output is cached on disk under a hash of everything that goes into it, so
+// a shader is only compiled again when its source, defines or options change.
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#ifdef AULE_WITH_SHADERC
+#include <shaderc/shaderc.h>
+#ifndef AULE_COMPILER_ID
+#define AULE_COMPILER_ID "shaderc" // The Makefile adds its version
+#endif
+#endif
+
+#include "results.h" // hashBytes, partPath
+
+	struct CompileOptions {
+		std::string optimization = "performance"; // 0, s(ize) or performance, as glslc's -O0, -Os and -O
+		std::vector<std::string> defines; // NAME or NAME=VALUE
+		bool cache = true;
+		std::string cacheDir = "."; // Holds aule_<hash>.spirv, not .spv so shader directories skip them
+	};
+
+	// .frag, .vert and .comp are GLSL, everything else is taken to be SPIR-V.
+	inline bool isGlsl(const std::string& filename){
+		std::string extension = std::filesystem::path(filename).extension().string();
+		return extension == ".frag" || extension == ".vert" || extension == ".comp";
+	}
+
+	inline std::vector<char> readBytes(const std::string& filename){
+		std::ifstream file(filename, std::ios::binary);
+		if(!file.is_open()){
+			throw std::runtime_error("failed to open " + filename);
+		}
+		return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+#ifdef AULE_WITH_SHADERC
+	inline std::vector<char> runShaderc(const std::string& filename, const std::vector<char>& source, const CompileOptions& options){
+		shaderc_shader_kind kind = shaderc_glsl_fragment_shader;
+		std::string extension = std::filesystem::path(filename).extension().string();
+		if(extension == ".vert"){
+			kind = shaderc_glsl_vertex_shader;
+		} else if(extension == ".comp"){
+			kind = shaderc_glsl_compute_shader;
+		}
+
+		shaderc_compiler_t compiler = shaderc_compiler_initialize();
+		shaderc_compile_options_t compileOptions = shaderc_compile_options_initialize();
+		shaderc_compile_options_set_target_env(compileOptions, shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_0);
+		if(options.optimization == "0"){
+			shaderc_compile_options_set_optimization_level(compileOptions, shaderc_optimization_level_zero);
+		} else if(options.optimization == "s"){
+			shaderc_compile_options_set_optimization_level(compileOptions, shaderc_optimization_level_size);
+		} else {
+			shaderc_compile_options_set_optimization_level(compileOptions, shaderc_optimization_level_performance);
+		}
+		for(const std::string& define : options.defines){
+			size_t equals = define.find('=');
+			std::string name = define.substr(0, equals);
+			std::string value = equals == std::string::npos ? "" : define.substr(equals + 1);
+			shaderc_compile_options_add_macro_definition(compileOptions, name.data(), name.size(), value.data(), value.size());
+		}
+
+		shaderc_compilation_result_t result = shaderc_compile_into_spv(compiler, source.data(), source.size(),
+				kind, filename.c_str(), "main", compileOptions);
+		std::string errors = shaderc_result_get_error_message(result);
+		bool compiled = shaderc_result_get_compilation_status(result) == shaderc_compilation_status_success;
+		std::vector<char> spirv;
+		if(compiled){
+			const char* bytes = shaderc_result_get_bytes(result);
+			spirv.assign(bytes, bytes + shaderc_result_get_length(result));
+		}
+
+		shaderc_result_release(result);
+		shaderc_compile_options_release(compileOptions);
+		shaderc_compiler_release(compiler);
+
+		if(!compiled){
+			throw std::runtime_error("failed to compile " + filename + ":\n" + errors);
+		}
+		return spirv;
+	}
+#endif
+
+	// SPIR-V for a GLSL file, from the cache if it has been compiled the same
+	// way before. #include is not supported, as included files would have to
+	// be part of the key.
+	inline std::vector<char> compileGlsl(const std::string& filename, const CompileOptions& options){
+#ifndef AULE_WITH_SHADERC
+		// Nothing could have been cached under this build's key either.
+		throw std::runtime_error(filename + " is GLSL, but this build has no compiler; rebuild with make SHADERC=1 or compile it with glslc");
+#else
+		std::vector<char> source = readBytes(filename);
+
+		// The stage comes from the extension, so it is part of the key too.
+		std::string key = std::filesystem::path(filename).extension().string() + '\0' + options.optimization + '\0';
+		for(const std::string& define : options.defines){
+			key += define + '\0';
+		}
+		// The compiler as built against, so upgrading it compiles everything
+		// again, and the SPIR-V version it targets.
+		key += std::string(AULE_COMPILER_ID) + '\0';
+		unsigned int version, revision;
+		shaderc_get_spv_version(&version, &revision);
+		key += std::to_string(version) + "." + std::to_string(revision) + '\0';
+		key.append(source.begin(), source.end());
+
+		char name[64];
+		snprintf(name, sizeof(name), "/aule_%016llx.spirv", static_cast<unsigned long long>(hashBytes(key.data(), key.size())));
+		std::string cachePath = options.cacheDir + name;
+		if(options.cache && std::filesystem::exists(cachePath)){
+			return readBytes(cachePath);
+		}
+
+		std::vector<char> spirv = runShaderc(filename, source, options);
+
+		// Written aside and renamed, so concurrent runs never read half a file.
+		if(options.cache){
+			std::string part = partPath(cachePath);
+			{
+				std::ofstream cacheFile(part, std::ios::binary);
+				cacheFile.write(spirv.data(), spirv.size());
+			}
+			std::filesystem::rename(part, cachePath);
+		}
+		return spirv;
+#endif
+	}
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef AULE_IMAGE_H
+#define AULE_IMAGE_H
+
+// Binary PPM (P6) images, enough to keep golden images and heatmaps around
+// without an image library, and the generated contents of input textures.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+	// Read a P6 file into RGBA pixels, alpha opaque.
+	inline std::vector<uint8_t> readPpm(const std::string& filename, uint32_t& width, uint32_t& height){
+		std::ifstream file(filename, std::ios::binary);
+		if(!file.is_open()){
+			throw std::runtime_error("failed to open " + filename);
+		}
+
+		// The header is whitespace separated, with # comments.
+		std::string fields[4];
+		for(std::string& field : fields){
+			while(file >> field && field[0] == '#'){
+				std::string comment;
+				std::getline(file, comment);
+			}
+		}
+		if(!file || fields[0] != "P6" || fields[3] != "255"){
+			throw std::runtime_error(filename + " is not an 8 bit binary PPM");
+		}
+		width = std::stoul(fields[1]);
+		height = std::stoul(fields[2]);
+		file.get(); // The single whitespace before the pixels
+
+		std::vector<uint8_t> rgb(size_t(width) * height * 3);
+		file.read(reinterpret_cast<char*>(rgb.data()), rgb.size());
+		if(!file){
+			throw std::runtime_error(filename + " is truncated");
+		}
+
+		std::vector<uint8_t> rgba(size_t(width) * height * 4);
+		for(size_t i = 0; i < size_t(width) * height; i++){
+			rgba[4 * i] = rgb[3 * i];
+			rgba[4 * i + 1] = rgb[3 * i + 1];
+			rgba[4 * i + 2] = rgb[3 * i + 2];
+			rgba[4 * i + 3] = 255;
+		}
+		return rgba;
+	}
+
+	// Write RGBA pixels as a P6 file, dropping alpha.
+	inline void writePpm(const std::string& filename, const uint8_t* rgba, uint32_t width, uint32_t height){
+		std::ofstream file(filename, std::ios::binary);
+		if(!file.is_open()){
+			throw std::runtime_error("failed to open " + filename);
+		}
+
+		file << "P6\n" << width << " " << height << "\n255\n";
+		std::vector<uint8_t> rgb(size_t(width) * height * 3);
+		for(size_t i = 0; i < size_t(width) * height; i++){
+			rgb[3 * i] = rgba[4 * i];
+			rgb[3 * i + 1] = rgba[4 * i + 1];
+			rgb[3 * i + 2] = rgba[4 * i + 2];
+		}
+		file.write(reinterpret_cast<const char*>(rgb.data()), rgb.size());
+	}
+
+	// RGBA texels in 0..1 for a texture's contents. noise is different at every
+	// texel, the worst case for texture caches and compression; gradient changes
+	// slowly and checker in 8 texel squares.
+	inline std::vector<float> makePattern(const std::string& pattern, uint32_t width, uint32_t height, uint32_t seed){
+		std::vector<float> rgba(size_t(width) * height * 4);
+		for(uint32_t y = 0; y < height; y++){
+			for(uint32_t x = 0; x < width; x++){
+				float* texel = &rgba[4 * (size_t(y) * width + x)];
+				if(pattern == "noise"){
+					for(uint32_t c = 0; c < 4; c++){
+						// A hash of the texel, channel and seed, so runs see the same noise.
+						uint32_t h = (x * 73856093u) ^ (y * 19349663u) ^ (c * 83492791u) ^ (seed * 2654435761u);
+						h ^= h >> 16;
+						h *= 0x7feb352du;
+						h ^= h >> 15;
+						h *= 0x846ca68bu;
+						h ^= h >> 16;
+						texel[c] = (h >> 8) / 16777216.0f;
+					}
+				} else if(pattern == "gradient"){
+					texel[0] = (x + 0.5f) / width;
+					texel[1] = (y + 0.5f) / height;
+					texel[2] = 0.5f;
+					texel[3] = 1.0f;
+				} else if(pattern == "checker"){
+					float value = ((x / 8 + y / 8) % 2) ? 1.0f : 0.0f;
+					texel[0] = texel[1] = texel[2] = value;
+					texel[3] = 1.0f;
+				} else {
+					throw std::runtime_error("unknown pattern " + pattern + ", expected noise, gradient or checker");
+				}
+			}
+		}
+		return rgba;
+	}
+
+	// Round to nearest half float, flushing what is too small to zero.
+	inline uint16_t floatToHalf(float value){
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		uint16_t sign = (bits >> 16) & 0x8000;
+		int32_t exponent = int32_t((bits >> 23) & 0xff) - 127 + 15;
+		uint32_t mantissa = bits & 0x7fffff;
+		if(exponent <= 0){
+			return sign;
+		}
+		if(exponent >= 31){
+			return sign | 0x7c00;
+		}
+		uint32_t half = (uint32_t(exponent) << 10) | (mantissa >> 13);
+		half += (mantissa >> 12) & 1; // A carry into the exponent is still right
+		return sign | uint16_t(std::min<uint32_t>(half, 0x7c00));
+	}
+
+	// The first channels of each RGBA texel, as unorm bytes, half floats or
+	// floats for 1, 2 or 4 bytes a channel.
+	inline std::vector<uint8_t> packTexels(const std::vector<float>& rgba, uint32_t channels, uint32_t bytesPerChannel){
+		size_t texels = rgba.size() / 4;
+		std::vector<uint8_t> packed(texels * channels * bytesPerChannel);
+		for(size_t i = 0; i < texels; i++){
+			for(uint32_t c = 0; c < channels; c++){
+				float value = rgba[4 * i + c];
+				uint8_t* out = &packed[(i * channels + c) * bytesPerChannel];
+				if(bytesPerChannel == 1){
+					*out = uint8_t(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+				} else if(bytesPerChannel == 2){
+					uint16_t half = floatToHalf(value);
+					memcpy(out, &half, sizeof(half));
+				} else {
+					memcpy(out, &value, sizeof(value));
+				}
+			}
+		}
+		return packed;
+	}
+
+#endif
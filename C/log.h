@@ -0,0 +1,122 @@
+#ifndef AULE_LOG_H
+#define AULE_LOG_H
+
+// Validation messages in the debug profile. The messenger may be called from
+// any thread the driver likes, in the middle of a frame, so it only copies the
+// message into a queue; printing happens on a thread of its own.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#define LOG_QUEUE_SIZE 1024 // Messages waiting to be printed before new ones are dropped, a power of two
+#define LOG_MESSAGE_SIZE 1024 // Longer messages are cut short
+
+	// Bounded lock-free queue for many producers and one consumer, after Dmitry
+	// Vyukov's: each slot's sequence number says whether it is free to write or
+	// ready to read, so a push is one compare-and-swap and never waits.
+	class MessageQueue {
+	public:
+		MessageQueue() : slots(new Slot[LOG_QUEUE_SIZE]) {
+			for(size_t i = 0; i < LOG_QUEUE_SIZE; i++){
+				slots[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		// False, and counted, when the queue is full.
+		bool push(const char* prefix, const char* message){
+			size_t position = tail.load(std::memory_order_relaxed);
+			for(;;){
+				Slot& slot = slots[position & (LOG_QUEUE_SIZE - 1)];
+				size_t sequence = slot.sequence.load(std::memory_order_acquire);
+				intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+				if(difference == 0){
+					if(tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+						snprintf(slot.text, LOG_MESSAGE_SIZE, "%s%s", prefix, message);
+						slot.sequence.store(position + 1, std::memory_order_release);
+						return true;
+					}
+				} else if(difference < 0){
+					dropped.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				} else {
+					position = tail.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		// Only ever called from the one consumer thread.
+		bool pop(std::string& text){
+			Slot& slot = slots[head & (LOG_QUEUE_SIZE - 1)];
+			if(slot.sequence.load(std::memory_order_acquire) != head + 1){
+				return false;
+			}
+			text = slot.text;
+			slot.sequence.store(head + LOG_QUEUE_SIZE, std::memory_order_release);
+			head++;
+			return true;
+		}
+
+		size_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+	private:
+		struct Slot {
+			std::atomic<size_t> sequence;
+			char text[LOG_MESSAGE_SIZE];
+		};
+		std::unique_ptr<Slot[]> slots;
+		alignas(64) std::atomic<size_t> tail{0}; // Producers and the consumer on their own cache lines
+		alignas(64) size_t head = 0;
+		std::atomic<size_t> dropped{0};
+	};
+
+	// Prints whatever is queued to stderr, on its own thread.
+	class Logger {
+	public:
+		~Logger(){
+			stop();
+		}
+
+		void start(){
+			running = true;
+			thread = std::thread([this](){
+				std::string text;
+				while(running.load(std::memory_order_acquire)){
+					if(!queue.pop(text)){
+						std::this_thread::sleep_for(std::chrono::milliseconds(1));
+						continue;
+					}
+					std::cerr << text << '\n';
+				}
+				while(queue.pop(text)){
+					std::cerr << text << '\n';
+				}
+				std::cerr.flush();
+			});
+		}
+
+		// Prints what is left, then joins.
+		void stop(){
+			if(!thread.joinable()){
+				return;
+			}
+			running = false;
+			thread.join();
+			if(queue.droppedCount() > 0){
+				std::cerr << queue.droppedCount() << " validation messages dropped, the queue was full" << std::endl;
+			}
+		}
+
+		MessageQueue queue;
+
+	private:
+		std::thread thread;
+		std::atomic<bool> running{false};
+	};
+
+#endif
@@ -3,11 +3,30 @@
 
 //useful things
 #include <cstring>
+#include <cstdio>
 #include <set>
+#include <optional>
 #include <iostream>
 #include <fstream>
 #include <chrono>
 #include <thread>
+#include <future>
+#include <filesystem>
+#include <algorithm>
+#include <cctype>
+
+#ifdef __linux__
+#include <sys/inotify.h> // Watch mode
+#include <unistd.h>
+#endif
+
+// Frame time recording and results files
+#include "results.h"
+#include "stats.h"
+#include "image.h"
+#include "compile.h"
+#include "log.h"
+#include "spirv.h"
 
 // To handle errors in C++. 
 #include <iostream>
@@ -17,11 +36,30 @@
 
 // Size of window/framebuffer, length of each test etc...
 
-#define WIDTH 1920
+#define WIDTH 1920 // Default size, --size changes it
 #define HEIGHT 1080
-
+#define OFFSCREEN_IMAGE_COUNT 3 // Images rendered in turn when there is no swapchain
+#define DEFAULT_FRAME_COUNT 1000 // Frames per shader when there is no window to close, or several shaders
+#define MAX_FRAMES_IN_FLIGHT 4 // Deepest CPU/GPU pipelining we allow
+#define DEFAULT_WARMUP_FRAMES 60 // Frames left out of the summary while clocks and caches settle
+#define DEFAULT_WINDOW_FRAMES 100 // Frames between convergence and steady state checks
+#define DEFAULT_STABLE_WINDOWS 3 // Windows in a row that must meet the convergence target
+#define DEFAULT_MAX_FRAMES 100000 // Give up converging after this many frames
+#define MAX_PASSES 4096 // Most full screen passes drawn per frame
+#define CALIBRATION_FRAMES 100 // Frames drawn to try out each pass count
+#define CALIBRATION_GPU_SHARE 0.9 // Share of the frame time the GPU must take up
+#define VERIFY_GROUP_SIZE 256 // local_size_x of verify.comp
+#define DEFAULT_BLOCK_FRAMES 10 // Frames each shader draws in a row when interleaving
+#define HEATMAP_FRAMES 20 // Frames timed tile by tile, the median is kept
+#define DEFAULT_COMPARE_THRESHOLD 0.02 // Relative slowdown of the median that --compare fails on
+#define DEFAULT_COMPARE_ALPHA 0.01 // Significance the slowdown must reach as well
+#define UNIFORM_PARAMS_OFFSET 32 // Where the parameter block starts in the uniform buffer, after the frame inputs
+
+// The debug profile loads the first of these the loader has; the measure
+// profile loads no layers at all.
 const std::vector<const char*> validationLayers = {
-	"VK_LAYER_LUNARG_standard_validation" // Does very basic checks on shaders etc.
+	"VK_LAYER_KHRONOS_validation",
+	"VK_LAYER_LUNARG_standard_validation" // Older SDKs
 	// "VK_LAYER_LUNARG_api_dump" No more dumping!
 };
 
@@ -29,6 +67,123 @@ const std::vector<const char*> deviceExtensions = {
 	VK_KHR_SWAPCHAIN_EXTENSION_NAME // Ability to output to a display(s buffer)
 };
 
+	// A storage buffer or storage image handed to a compute shader.
+	struct ComputeBinding {
+		bool image = false;
+		VkDeviceSize size = 0; // Bytes, for a buffer
+		VkExtent2D extent = {}; // For an image, which is rgba8
+	};
+
+	// A sampled texture or storage buffer bound to fragment shaders at set 1.
+	struct ResourceBinding {
+		std::string spec; // As given, for the summary
+		bool texture = false;
+		VkDeviceSize size = 0; // Bytes, for a buffer
+		VkExtent2D extent = {}; // For a texture, of its largest mip
+		VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+		uint32_t mipLevels = 1; // 0 for a full chain, made by blitting each level from the one above
+		VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL;
+		VkFilter filter = VK_FILTER_LINEAR; // For magnification, minification and between mips
+		std::string data; // A pattern (noise, gradient, checker; noise, ramp, zero for buffers), or a file
+	};
+
+	// Texture formats --texture takes, and how their texels are packed.
+	struct TextureFormat {
+		const char* name;
+		VkFormat format;
+		uint32_t channels;
+		uint32_t bytesPerChannel; // 1 for unorm, 2 for half float, 4 for float
+	};
+	const TextureFormat textureFormats[] = {
+		{"rgba8", VK_FORMAT_R8G8B8A8_UNORM, 4, 1},
+		{"srgb8", VK_FORMAT_R8G8B8A8_SRGB, 4, 1},
+		{"rg8", VK_FORMAT_R8G8_UNORM, 2, 1},
+		{"r8", VK_FORMAT_R8_UNORM, 1, 1},
+		{"rgba16f", VK_FORMAT_R16G16B16A16_SFLOAT, 4, 2},
+		{"r16f", VK_FORMAT_R16_SFLOAT, 1, 2},
+		{"rgba32f", VK_FORMAT_R32G32B32A32_SFLOAT, 4, 4},
+		{"r32f", VK_FORMAT_R32_SFLOAT, 1, 4},
+	};
+
+	const TextureFormat& textureFormat(VkFormat format){
+		for(const TextureFormat& candidate : textureFormats){
+			if(candidate.format == format){
+				return candidate;
+			}
+		}
+		throw std::runtime_error("unsupported texture format");
+	}
+
+	// A specialization constant and the values to benchmark it at, each kept as
+	// the 4 bytes the shader sees.
+	struct SpecConstant {
+		uint32_t id;
+		std::vector<uint32_t> values;
+		std::vector<std::string> names; // As given, for labelling results
+	};
+
+	// ShaderToy-style inputs, as push constants and at the start of the uniform
+	// buffer. In GLSL:
+	//   layout(push_constant) uniform Inputs { float time; uint frame; vec2 resolution; uint seed; };
+	struct FrameInputs {
+		float time; // Seconds since the shader started
+		uint32_t frame;
+		float resolution[2]; // Pixels, or workgroups in compute mode
+		uint32_t seed;
+	};
+	static_assert(sizeof(FrameInputs) <= UNIFORM_PARAMS_OFFSET, "frame inputs overlap the parameter block");
+
+	// Options given on the command line
+	struct TestConfig {
+		bool headless = false; // Render offscreen, no window, surface or swapchain
+		bool convert = false; // Turn results files back into text, no rendering
+		bool compare = false; // Test two results files for a regression, no rendering
+		double compareThreshold = DEFAULT_COMPARE_THRESHOLD;
+		double compareAlpha = DEFAULT_COMPARE_ALPHA;
+		uint32_t frameCount = 0; // Stop after this many frames, 0 runs until the window closes
+		uint32_t framesInFlight = 2; // Frames the CPU may queue ahead of the GPU
+		bool latencyMode = false; // Wait for each frame to finish before starting the next
+		bool pipelineCache = true; // Keep compiled pipelines on disk between runs
+		std::string pipelineCacheDir = "."; // Where the pipeline cache files live
+		uint32_t warmupFrames = DEFAULT_WARMUP_FRAMES; // Left out of the summary statistics
+		bool keepSamples = true; // Write every frame time, not just the summary
+		double duration = 0.0; // Stop after this many seconds, 0 for no limit
+		double convergeTarget = 0.0; // Stop once the median's relative CI width is below this, 0 to never
+		uint32_t windowFrames = DEFAULT_WINDOW_FRAMES;
+		uint32_t stableWindows = DEFAULT_STABLE_WINDOWS;
+		bool steadyState = false; // Leave the clock ramp at the start out of the statistics
+		uint32_t width = WIDTH; // Size of the window, or of the offscreen images
+		uint32_t height = HEIGHT;
+		std::vector<VkExtent2D> sweep; // Sizes to render each shader at in turn, headless only
+		uint32_t passes = 1; // Full screen passes drawn per frame
+		bool instanced = false; // Draw the passes as instances of one draw, not separate draws
+		bool calibratePasses = false; // Raise passes until the GPU time dominates the frame
+		bool compute = false; // The shaders are compute shaders, dispatched rather than drawn
+		uint32_t dispatch[3] = {1, 1, 1}; // Workgroups per dispatch
+		std::vector<ComputeBinding> bindings; // Set 0, binding i is the i-th one given
+		bool inputs = false; // Give shaders the frame inputs, re-recording every frame to do so
+		uint32_t seed = 0; // Handed to the shaders as is
+		std::string paramsFile; // Raw bytes for the uniform buffer's parameter block
+		std::vector<SpecConstant> specConstants; // Every combination of their values is benchmarked
+		std::vector<ResourceBinding> resources; // Set 1, binding i is the i-th one given
+		bool verify = false; // Check the last frame rendered against its golden image, headless only
+		bool writeGolden = false; // Keep the last frame rendered as the golden image instead
+		std::string goldenDir = "."; // Where golden images live, as <shader>.ppm
+		uint32_t tolerance = 2; // Per channel difference from the golden image that still matches
+		std::string device; // Index, UUID or part of the name, empty for the best scoring device
+		std::string deviceLabel; // Added to every output name when running on all devices
+		bool listDevices = false;
+		bool allDevices = false; // A thread per suitable device, headless only
+		std::string vertexShader = "./vert.spv"; // SPIR-V or GLSL
+		bool watch = false; // Rebuild the shader whenever its file changes, until stopped
+		CompileOptions compile; // For shaders given as GLSL
+		bool debug = false; // The debug profile, with validation; otherwise nothing between us and the driver
+		VkExtent2D heatmap = {}; // Tiles across and down to time separately, none when 0
+		bool executableIr = false; // Keep the driver's internal representations of each pipeline too
+		bool interleave = false; // Draw every shader from one loop, in shuffled blocks of frames
+		uint32_t blockFrames = DEFAULT_BLOCK_FRAMES;
+	};
+
 	//Callback register helper function
 	VkResult CreateDebugUtilsMessengerEXT(
 			VkInstance instance, 
@@ -56,29 +211,116 @@ const std::vector<const char*> deviceExtensions = {
 
 	class ShaderTester {
 	public: 
+		ShaderTester(const TestConfig& config) : config(config) {
+			makeVariants();
+		}
 
-		// Open a window, set up the graphics card, render something, then close down.
-		void run(std::string shader){
-			initWindow();
-			initVulkan(shader);
-			mainLoop(shader);
+		// Open a window, set up the graphics card, render each shader in turn, then close down.
+		// Only the pipeline and command buffers are rebuilt between shaders.
+		void run(const std::vector<std::string>& shaders){
+			if(!config.headless){
+				initWindow();
+			}
+			initVulkan();
+			if(config.interleave){
+				interleaveShaders(shaders);
+			} else {
+				for(const std::string& shader : shaders){
+					if(!config.headless && glfwWindowShouldClose(window)){
+						break;
+					}
+					loadShader(shader);
+					std::string name = named(shader);
+					if(config.calibratePasses){
+						calibratePasses(name);
+					}
+					if(config.watch){
+						watchLoop(name, shader);
+					} else if(variants.size() > 1){
+						benchmarkVariants(name);
+					} else if(config.sweep.empty()){
+						mainLoop(name);
+					} else {
+						sweepSizes(name);
+					}
+					if(config.heatmap.width > 0){
+						renderHeatmap(name);
+					}
+					unloadShader();
+				}
+			}
+			finishVerification();
 			cleanup();
+			if(staticRows.size() > 1){
+				writeStaticReport();
+			}
+
+			if(verifyFailures > 0){
+				throw std::runtime_error(std::to_string(verifyFailures) + " rendered frames did not match their golden images");
+			}
+		}
+
+		// Print every device, whether we could use it, and how to pick it.
+		void listDevices(){
+			createInstance();
+			std::vector<VkPhysicalDevice> devices = enumerateDevices();
+			for(size_t i = 0; i < devices.size(); i++){
+				VkPhysicalDeviceProperties deviceProperties;
+				vkGetPhysicalDeviceProperties(devices[i], &deviceProperties);
+				std::cout << i << ": " << deviceProperties.deviceName << " (" << deviceTypeName(deviceProperties.deviceType)
+					<< "), uuid " << deviceUuid(devices[i]) << ", vulkan " << VK_VERSION_MAJOR(deviceProperties.apiVersion)
+					<< "." << VK_VERSION_MINOR(deviceProperties.apiVersion) << ", score " << getDeviceScore(devices[i])
+					<< (isDeviceSuitable(devices[i]) ? "" : ", not suitable") << std::endl;
+			}
+			vkDestroyInstance(instance, nullptr);
+		}
+
+		// Index and name of every device this configuration can run on.
+		std::vector<std::pair<uint32_t, std::string>> suitableDevices(){
+			createInstance();
+			std::vector<std::pair<uint32_t, std::string>> suitable;
+			std::vector<VkPhysicalDevice> devices = enumerateDevices();
+			for(uint32_t i = 0; i < devices.size(); i++){
+				if(isDeviceSuitable(devices[i])){
+					VkPhysicalDeviceProperties deviceProperties;
+					vkGetPhysicalDeviceProperties(devices[i], &deviceProperties);
+					suitable.push_back({i, deviceProperties.deviceName});
+				}
+			}
+			vkDestroyInstance(instance, nullptr);
+			return suitable;
 		}
 
 	private:
 		
-		// The callback routine that any testbed should use.
+		// The callback routine that any testbed should use. It may be called on
+		// any thread mid-frame, so it only queues the message for the logger.
 		static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
 				VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
 				VkDebugUtilsMessageTypeFlagsEXT messageType,
 				const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
 				void* pUserData){
-			std::cerr << "validation layer: " << pCallbackData->pMessage << std::endl;
+			MessageQueue* queue = static_cast<MessageQueue*>(pUserData);
+			if(messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT){
+				queue->push("validation error: ", pCallbackData->pMessage);
+			} else if(messageType & VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT){
+				queue->push("validation performance warning: ", pCallbackData->pMessage);
+			} else {
+				queue->push("validation warning: ", pCallbackData->pMessage);
+			}
 
 			return VK_FALSE;
 		}
 
 		// Loads shaders
+		// SPIR-V as given, or compiled from GLSL.
+		std::vector<char> loadSpirv(const std::string& filename){
+			if(isGlsl(filename)){
+				return compileGlsl(filename, config.compile);
+			}
+			return readFile(filename);
+		}
+
 		static std::vector<char> readFile(const std::string& filename) {
 			std::ifstream file(filename, std::ios::ate | std::ios::binary);
 
@@ -99,84 +341,276 @@ const std::vector<const char*> deviceExtensions = {
 		}
 
 		// All the class members
+		TestConfig config;
+
 		// The window & surface
 		VkSurfaceKHR surface;
 		GLFWwindow* window;
 
 		// Vulkan instance things
 		VkInstance instance;
-		VkDebugUtilsMessengerEXT callback;
+		VkDebugUtilsMessengerEXT callback = VK_NULL_HANDLE;
+		std::vector<const char*> layers; // Loaded on the instance and device, none when measuring
+		bool hasDebugUtils = false;
+		Logger logger; // Prints validation messages off the frame loop's thread
 		VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+		bool hasProperties2 = false; // VK_KHR_get_physical_device_properties2 is enabled
+		bool hasExecutableProperties = false; // VK_KHR_pipeline_executable_properties, pipelines capture statistics
+		PFN_vkGetPipelineExecutablePropertiesKHR getPipelineExecutableProperties = nullptr;
+		PFN_vkGetPipelineExecutableStatisticsKHR getPipelineExecutableStatistics = nullptr;
+		PFN_vkGetPipelineExecutableInternalRepresentationsKHR getPipelineExecutableInternalRepresentations = nullptr;
 		VkDevice lDevice;
 
 		// Vulkan queue
 		VkQueue graphicsQueue;
 		VkQueue presentQueue;
+		VkQueue computeQueue; // Only fetched in compute mode
 
 		// Vulkan swapqueue
 		VkSwapchainKHR swapChain;
 		std::vector<VkImage> swapChainImages;
 		std::vector<VkImageView> swapChainImageViews;
 		VkFormat swapChainImageFormat;
-		VkExtent2D swapChainExtent;
+		VkExtent2D swapChainExtent = {}; // Stays 0x0 in compute mode
+
+		// Offscreen images standing in for the swapchain when headless
+		std::vector<VkDeviceMemory> offscreenImageMemory;
+		uint32_t nextOffscreenImage = 0;
 
 		// Vulkan Rendering
 		VkRenderPass renderPass;
 		VkPipelineLayout pipelineLayout;
 		VkPipeline graphicsPipeline;
+		VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+		std::string pipelineCachePath;
+
+		// One combination of specialization constant values. A run without any
+		// constants has a single variant that specializes nothing.
+		struct Variant {
+			std::string name;
+			std::vector<uint32_t> data;
+			std::vector<VkSpecializationMapEntry> entries;
+			VkSpecializationInfo info;
+		};
+		std::vector<Variant> variants;
+		std::vector<VkPipeline> variantPipelines; // Of the shader being measured, by variant
+
+		// Compute mode: the pipeline, and the buffers and images bound to it.
+		// The resources are made once and shared by every shader.
+		VkPipeline computePipeline;
+		VkDescriptorSetLayout computeSetLayout = VK_NULL_HANDLE;
+		VkDescriptorPool computeDescriptorPool = VK_NULL_HANDLE;
+		VkDescriptorSet computeDescriptorSet = VK_NULL_HANDLE;
+		std::vector<VkBuffer> computeBuffers;
+		std::vector<VkImage> computeImages;
+		std::vector<VkImageView> computeImageViews;
+		std::vector<VkDeviceMemory> computeMemory;
+
+		// Fragment shader resources at set 1, uploaded once and shared by every
+		// shader. Set 0 is the frame inputs', or empty without them.
+		VkDescriptorSetLayout emptySetLayout = VK_NULL_HANDLE;
+		VkDescriptorSetLayout resourceSetLayout = VK_NULL_HANDLE;
+		VkDescriptorPool resourceDescriptorPool = VK_NULL_HANDLE;
+		VkDescriptorSet resourceDescriptorSet = VK_NULL_HANDLE;
+		std::vector<VkBuffer> resourceBuffers;
+		std::vector<VkImage> resourceImages;
+		std::vector<VkImageView> resourceImageViews;
+		std::vector<VkSampler> resourceSamplers;
+		std::vector<VkDeviceMemory> resourceMemory;
+
+		// Frame inputs: push constants, and a uniform buffer per frame in flight,
+		// mapped for the whole run so updating one is a memcpy.
+		FrameInputs frameInputs = {};
+		std::chrono::steady_clock::time_point inputsStart;
+		VkDescriptorSetLayout inputsSetLayout = VK_NULL_HANDLE;
+		VkDescriptorPool inputsDescriptorPool = VK_NULL_HANDLE;
+		std::vector<VkDescriptorSet> inputsDescriptorSets;
+		std::vector<VkBuffer> inputsBuffers;
+		std::vector<VkDeviceMemory> inputsMemory;
+		std::vector<char*> inputsMapped;
+
+		// Output verification: the last frame is copied to a staging buffer and
+		// reduced by verify.comp, while the next shader gets going.
+		struct VerifyResult {
+			uint32_t checksum;
+			uint32_t mismatched;
+			uint32_t maxError[4];
+			uint32_t sumErrorLow[4];
+			uint32_t sumErrorHigh[4];
+		};
+		VkPipeline verifyPipeline;
+		VkPipelineLayout verifyPipelineLayout;
+		VkDescriptorSetLayout verifySetLayout = VK_NULL_HANDLE;
+		VkDescriptorPool verifyDescriptorPool = VK_NULL_HANDLE;
+		VkDescriptorSet verifySet;
+		VkCommandBuffer verifyCommandBuffer;
+		VkFence verifyFence;
+		VkBuffer stagingBuffer = VK_NULL_HANDLE; // The frame, then the golden image, both kept for the next shader
+		VkBuffer goldenBuffer = VK_NULL_HANDLE;
+		VkBuffer verifyResultBuffer;
+		VkDeviceMemory stagingMemory;
+		VkDeviceMemory goldenMemory;
+		VkDeviceMemory verifyResultMemory;
+		void* stagingMapped;
+		void* goldenMapped;
+		void* verifyResultMapped;
+		VkDeviceSize verifyBufferSize = 0;
+		VkExtent2D verifyExtent;
+		std::string verifyLabel; // The shader whose frame is being verified
+		bool verifyPending = false;
+		bool verifyCompare = false; // There is a golden image to compare with
+		uint32_t verifyFailures = 0;
+		uint32_t lastImageIndex = 0; // Image the last frame was drawn to
 		
 		// Drawing
 		std::vector<VkFramebuffer> swapChainFramebuffers;
 		VkCommandPool commandPool;
 		std::vector<VkCommandBuffer> commandBuffers;
-		
-		//Synchronisation
-		VkSemaphore imageAvailableSemaphore;
-		VkSemaphore renderFinishedSemaphore;
 
-		// Open a window, using the vulkan API for rendering, which is WIDTHxHEIGHT 
-		// in size (and fixed size).
+		// GPU timing, a pair of timestamps around the draw in each command buffer
+		VkQueryPool timestampPool;
+		float timestampPeriod; // Nanoseconds per timestamp tick
+		uint64_t timestampMask; // Bits of each timestamp that are valid
+
+		// Work done by the draw, one pipeline statistics query per command buffer.
+		// Left as VK_NULL_HANDLE when the device can't count.
+		VkQueryPool statisticsPool = VK_NULL_HANDLE;
+		struct PipelineCounts {
+			// In the order the query returns them, which is flag bit order.
+			uint64_t vertexInvocations = 0;
+			uint64_t clippingInvocations = 0; // Primitives reaching the clipper
+			uint64_t clippingPrimitives = 0; // Primitives leaving it
+			uint64_t fragmentInvocations = 0; // May include helper invocations
+			uint64_t computeInvocations = 0; // The only counter in compute mode
+		};
+		PipelineCounts pipelineTotals; // Summed over the frames of the current shader
+		uint64_t pipelineFrames;
+
+		// Frames whose GPU time has not been read back yet, by image
+		struct PendingFrame {
+			bool pending = false;
+			float frameTime_us;
+			uint32_t arm = 0; // Shader the frame was drawn with, when interleaving
+		};
+		std::vector<PendingFrame> pendingFrames;
+		FrameRecorder recorder; // Frame times of the shader being measured
+		SampleStats frameTimeStats;
+		SampleStats gpuTimeStats;
+		SteadyStateDetector rampDetector;
+		uint64_t rampFrames; // Frames before the GPU time settled, left out of the summary once it has
+		std::string stopReason;
+		uint32_t convergedWindows;
+		bool calibrating = false; // Trying out pass counts, nothing is being measured
+
+		// Interleaved runs: each shader's pipeline, and the frames drawn with it.
+		struct Arm {
+			std::string name;
+			VkPipeline pipeline;
+			VkPipelineLayout layout;
+			uint64_t hash;
+			SpirvStats stats;
+			bool compiled;
+			FrameRecorder recorder;
+			SampleStats frameTimeStats;
+			SampleStats gpuTimeStats;
+			SteadyStateDetector rampDetector; // Fed this shader's frames only, so windows compare like with like
+			PipelineCounts pipelineTotals;
+			uint64_t pipelineFrames = 0;
+			uint64_t frames = 0; // Drawn, measured or not
+		};
+		std::vector<Arm> arms; // Empty unless interleaving
+		uint32_t currentArm = 0;
+
+		// One of the programs the driver compiled a pipeline into, and its
+		// statistics (registers, spills, instructions...), each kept as JSON.
+		struct PipelineExecutable {
+			std::string name;
+			std::string description;
+			VkShaderStageFlags stages;
+			uint32_t subgroupSize;
+			std::vector<std::pair<std::string, std::string>> statistics;
+		};
+
+		// A shader rebuilt off the frame loop's thread in watch mode.
+		struct Rebuild {
+			std::vector<VkPipeline> pipelines;
+			uint64_t hash;
+			SpirvStats stats;
+			float build_ms;
+			std::string report; // How the pipelines were created, printed once swapped in
+		};
+		uint64_t shaderHash; // Of the fragment shader's SPIR-V
+		bool shaderCompiled = false; // The shader was given as GLSL
+		SpirvStats shaderStats; // What its SPIR-V says it does
+
+		// Static features next to measured cost, a row per summary written.
+		struct StaticRow {
+			std::string shader;
+			SpirvStats stats;
+			double gpuTimePerPass_us;
+		};
+		std::vector<StaticRow> staticRows;
+		int32_t swapChainPresentMode = -1; // Never set when headless
+		
+		//Synchronisation, one set per frame in flight
+		std::vector<VkSemaphore> imageAvailableSemaphores;
+		std::vector<VkSemaphore> renderFinishedSemaphores;
+		std::vector<VkFence> inFlightFences;
+		std::vector<VkFence> imagesInFlight; // The frame fence each image was last submitted with
+		size_t currentFrame = 0;
+
+		// Open a window, using the vulkan API for rendering, which is the configured
+		// size (and fixed size).
 		void initWindow(){
 			glfwInit();
 			glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 			glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
-			window = glfwCreateWindow(WIDTH, HEIGHT, "Fragment Shader", nullptr, nullptr);	
+			window = glfwCreateWindow(config.width, config.height, "Fragment Shader", nullptr, nullptr);	
 		}
 			
 
-			// Ensure validation layers exist.
-		    bool checkValidationLayerSupport(){
-				// Find supported validation layers, store in availableLayers				
+			// The first validation layer the loader has, or nullptr.
+			const char* findValidationLayer(){
 				uint32_t layerCount;
 				vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
 
-			    std::vector<VkLayerProperties> availableLayers(layerCount);
-			    vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
-				
-				// For each layer we want, check if it is supported.
-				for (const char* layerName : validationLayers) {
-					bool layerFound = false;
+				std::vector<VkLayerProperties> availableLayers(layerCount);
+				vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
 
-		    			for (const auto& layerProperties : availableLayers) {
-				        	if (strcmp(layerName, layerProperties.layerName) == 0) {
-								layerFound = true;
-								break;
-							}
+				for (const char* layerName : validationLayers) {
+					for (const auto& layerProperties : availableLayers) {
+						if (strcmp(layerName, layerProperties.layerName) == 0) {
+							return layerName;
 						}
-
-			    	if (!layerFound) {
-						return false;
 					}
 				}
+				return nullptr;
+			}
 
-				return true;
-			
+			bool hasInstanceExtension(const char* name){
+				uint32_t extensionCount = 0;
+				vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+				std::vector<VkExtensionProperties> extensions(extensionCount);
+				vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+				for(const auto& extension : extensions){
+					if(strcmp(extension.extensionName, name) == 0){
+						return true;
+					}
+				}
+				return false;
 			}
 
 			// All the information the API needs to create an instance
 			void createInstance(){
-				if(!checkValidationLayerSupport()){
-					throw std::runtime_error("requested validation layers not available.");
+				// Measuring loads nothing that could get in the way of the driver.
+				layers.clear();
+				if(config.debug){
+					const char* layer = findValidationLayer();
+					if(layer != nullptr){
+						layers.push_back(layer);
+					} else {
+						std::cerr << "no validation layers installed, debugging without them" << std::endl;
+					}
 				}
 
 				//Information about the program
@@ -196,15 +630,27 @@ const std::vector<const char*> deviceExtensions = {
 					//GLFW automagically creates a struct containing the required extensions
 					//My project needs not concern itself with extensions, for now at least.
 					uint32_t glfwExtensionCount = 0;
-					const char** glfwExtensions;
+					const char** glfwExtensions = nullptr;
 
-					glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+					// Headless runs never touch GLFW, and need no surface extensions.
+					if(!config.headless){
+						glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+					}
 
-					// add the debug utilities extension.
 					std::vector<const char*> extensions(glfwExtensions, glfwExtensions + 
 							glfwExtensionCount);
 					
-					extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+					// add the debug utilities extension, when debugging.
+					hasDebugUtils = config.debug && hasInstanceExtension(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+					if(hasDebugUtils){
+						extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+					}
+
+					// Optional, for device UUIDs.
+					hasProperties2 = hasInstanceExtension(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+					if(hasProperties2){
+						extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+					}
 					
 					// Add the exensions
 					createInfo.enabledExtensionCount = 
@@ -213,9 +659,9 @@ const std::vector<const char*> deviceExtensions = {
 
 					// Add validation layers.
 					createInfo.enabledLayerCount = 
-						static_cast<uint32_t>(validationLayers.size());
+						static_cast<uint32_t>(layers.size());
 
-					createInfo.ppEnabledLayerNames = validationLayers.data();
+					createInfo.ppEnabledLayerNames = layers.data();
 
 				// Create the instance (information, allocation, location)
 				VkResult result = vkCreateInstance(&createInfo, nullptr, &instance);
@@ -225,19 +671,22 @@ const std::vector<const char*> deviceExtensions = {
 			}
 
 			void setupDebugCallback(){
+				if(!hasDebugUtils){
+					return;
+				}
+				logger.start();
+
 				VkDebugUtilsMessengerCreateInfoEXT createInfo = {};
 					createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
-					// All warnings, errors etc, but not normal information
-					createInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT 
-						| VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT 
+					// Warnings and errors, not the verbose chatter
+					createInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT 
 						| VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
 					createInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT
-			   			| VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT;
-						//| VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
-					// Print the information
+			   			| VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT
+						| VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+					// Queue the information for the logger thread
 					createInfo.pfnUserCallback = debugCallback;
-					// TODO: Pass a pointer to the relevant shader.
-					createInfo.pUserData = nullptr;
+					createInfo.pUserData = &logger.queue;
 				
 				//Attempt to add the callback.	
 				if(CreateDebugUtilsMessengerEXT(instance, &createInfo, nullptr, &callback) != VK_SUCCESS){
@@ -249,6 +698,7 @@ const std::vector<const char*> deviceExtensions = {
 				struct QueueFamilyIndices{
 					std::optional<uint32_t> graphicsFamily;
 					std::optional<uint32_t> presentFamily;
+					std::optional<uint32_t> computeFamily;
 
 					bool isComplete(){
 							return graphicsFamily.has_value() && presentFamily.has_value();
@@ -270,7 +720,9 @@ const std::vector<const char*> deviceExtensions = {
 					int i = 0;
 					for(const auto & queueFamily : queueFamilies){
 						VkBool32 presentSupport = false;
-						vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+						if(!config.headless){
+							vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+						}
 
 						if(queueFamily.queueCount > 0 && presentSupport){
 							indices.presentFamily = i;
@@ -280,6 +732,11 @@ const std::vector<const char*> deviceExtensions = {
 							indices.graphicsFamily = i;
 						}
 
+						// Nothing is presented when headless, the graphics queue stands in.
+						if(config.headless && indices.graphicsFamily.has_value()){
+							indices.presentFamily = indices.graphicsFamily;
+						}
+
 
 						if(indices.isComplete()){
 							break;
@@ -288,9 +745,45 @@ const std::vector<const char*> deviceExtensions = {
 						i++;
 					}
 
+					// Compute work goes to a family of its own when there is one, so it
+					// isn't sharing with graphics, otherwise to any that can compute.
+					for(uint32_t j = 0; j < queueFamilies.size(); j++){
+						if(queueFamilies[j].queueCount == 0 || !(queueFamilies[j].queueFlags & VK_QUEUE_COMPUTE_BIT)){
+							continue;
+						}
+						if(!(queueFamilies[j].queueFlags & VK_QUEUE_GRAPHICS_BIT) && queueFamilies[j].timestampValidBits > 0){
+							indices.computeFamily = j;
+							break;
+						}
+						if(!indices.computeFamily.has_value()){
+							indices.computeFamily = j;
+						}
+					}
+
 					return indices;
 				}
 
+				// The swapchain extension is only needed when presenting.
+				std::vector<const char*> requiredDeviceExtensions(){
+					if(config.headless){
+						return {};
+					}
+					return deviceExtensions;
+				}
+
+				bool hasDeviceExtension(VkPhysicalDevice device, const char* name){
+					uint32_t extensionCount;
+					vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+					std::vector<VkExtensionProperties> extensions(extensionCount);
+					vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
+					for(const auto& extension : extensions){
+						if(strcmp(extension.extensionName, name) == 0){
+							return true;
+						}
+					}
+					return false;
+				}
+
 				bool checkDeviceExtensionSupport(VkPhysicalDevice device){
 					//Get available extensions
 					uint32_t extensionCount;
@@ -299,7 +792,8 @@ const std::vector<const char*> deviceExtensions = {
 					vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
 					
 					// The required extensions in a set, so we can remove those we have on this device
-					std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+					std::vector<const char*> wantedExtensions = requiredDeviceExtensions();
+					std::set<std::string> requiredExtensions(wantedExtensions.begin(), wantedExtensions.end());
 	
 					for(const auto& extension : extensions){
 						requiredExtensions.erase(extension.extensionName);
@@ -313,9 +807,13 @@ const std::vector<const char*> deviceExtensions = {
 				bool isDeviceSuitable(VkPhysicalDevice device){
 					QueueFamilyIndices indices = findQueueFamilies(device);
 
+					if(config.compute) return indices.computeFamily.has_value() && checkDeviceExtensionSupport(device);
+
 					if(!indices.isComplete()) return false;
 
 					if(!checkDeviceExtensionSupport(device)) return false;
+
+					if(config.headless) return true;
 					
 					bool swapChainAdequate = false;
 					SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
@@ -325,44 +823,103 @@ const std::vector<const char*> deviceExtensions = {
 					return true;
 				}			
 	
-				//Give a device a score. 
+				//Give a device a score. Discrete GPUs first, then by how much memory they
+				//have of their own; software rasterizers come last but still count.
 				int getDeviceScore(VkPhysicalDevice device){
-					int score = 1;
-					
+					if(!isDeviceSuitable(device)){
+						return 0;
+					}
+
 					VkPhysicalDeviceProperties deviceProperties;
 					vkGetPhysicalDeviceProperties(device, &deviceProperties);
-					
-					VkPhysicalDeviceFeatures deviceFeatures;
-					vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
-										
-					if(isDeviceSuitable(device)){
-						return score;
+
+					int score = 1;
+					switch(deviceProperties.deviceType){
+						case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: score += 10000; break;
+						case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: score += 5000; break;
+						case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: score += 1000; break;
+						default: break;
+					}
+
+					VkPhysicalDeviceMemoryProperties memProperties;
+					vkGetPhysicalDeviceMemoryProperties(device, &memProperties);
+					for(uint32_t i = 0; i < memProperties.memoryHeapCount; i++){
+						if(memProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT){
+							score += static_cast<int>(memProperties.memoryHeaps[i].size >> 30); // GiB
+						}
+					}
+					return score;
+				}
+
+				static const char* deviceTypeName(VkPhysicalDeviceType type){
+					switch(type){
+						case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return "discrete";
+						case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return "integrated";
+						case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return "virtual";
+						case VK_PHYSICAL_DEVICE_TYPE_CPU: return "cpu";
+						default: return "other";
+					}
+				}
+
+				// The device UUID where the instance can ask for it, otherwise the
+				// pipeline cache UUID, which at least tells drivers and models apart.
+				std::string deviceUuid(VkPhysicalDevice device){
+					uint8_t uuid[VK_UUID_SIZE];
+					auto getProperties2 = (PFN_vkGetPhysicalDeviceProperties2KHR) vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties2KHR");
+					if(hasProperties2 && getProperties2 != nullptr){
+						VkPhysicalDeviceIDPropertiesKHR idProperties = {};
+						idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES_KHR;
+						VkPhysicalDeviceProperties2KHR properties = {};
+						properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+						properties.pNext = &idProperties;
+						getProperties2(device, &properties);
+						memcpy(uuid, idProperties.deviceUUID, VK_UUID_SIZE);
 					} else {
-						return 0;
+						VkPhysicalDeviceProperties deviceProperties;
+						vkGetPhysicalDeviceProperties(device, &deviceProperties);
+						memcpy(uuid, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE);
+					}
+
+					std::string hex;
+					char digits[3];
+					for(uint8_t byte : uuid){
+						snprintf(digits, sizeof(digits), "%02x", byte);
+						hex += digits;
 					}
+					return hex;
+				}
+
+				std::vector<VkPhysicalDevice> enumerateDevices(){
+					uint32_t deviceCount = 0;
+					vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+					std::vector<VkPhysicalDevice> devices(deviceCount);
+					vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+					return devices;
 				}
 			
-			// Choose a GPU!
+			// Choose a GPU! The one asked for, by index, UUID or name, or the best scoring.
 			void selectPhysicalDevice(){
-				// Get the devices
-				uint32_t deviceCount = 0;
-				uint32_t deviceScore = 0;
-				
-				vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
-
-				std::vector<VkPhysicalDevice> devices(deviceCount);
-				vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());	
+				std::vector<VkPhysicalDevice> devices = enumerateDevices();
 
 				if(devices.size() == 0) {
 					throw std::runtime_error("No GPUs found!");
 				}
+
+				if(!config.device.empty()){
+					physicalDevice = findDevice(devices, config.device);
+					if(!isDeviceSuitable(physicalDevice)){
+						throw std::runtime_error("device " + config.device + " is not suitable!");
+					}
+					return;
+				}
 				
 				// Select a device that is most suitable
+				int deviceScore = 0;
 				for(size_t i = 0; i < devices.size(); i++){
-					VkPhysicalDevice device = devices[i];
-					if(device != VK_NULL_HANDLE && getDeviceScore(device) > deviceScore){
-						physicalDevice = device;
-						deviceScore = getDeviceScore(device);
+					int score = getDeviceScore(devices[i]);
+					if(score > deviceScore){
+						physicalDevice = devices[i];
+						deviceScore = score;
 					}
 				}				
 
@@ -371,13 +928,53 @@ const std::vector<const char*> deviceExtensions = {
 					throw std::runtime_error("No suitable GPUs found!");
 				}
 			}
+
+			VkPhysicalDevice findDevice(const std::vector<VkPhysicalDevice>& devices, const std::string& wanted){
+				if(!wanted.empty() && std::all_of(wanted.begin(), wanted.end(), [](unsigned char c){ return std::isdigit(c); })){
+					size_t index = std::stoul(wanted);
+					if(index >= devices.size()){
+						throw std::runtime_error("there is no device " + wanted + "!");
+					}
+					return devices[index];
+				}
+
+				// UUIDs may be written with dashes, names in any case.
+				std::string uuid;
+				std::string lowered;
+				for(char c : wanted){
+					if(c != '-'){
+						uuid += std::tolower(c);
+					}
+					lowered += std::tolower(c);
+				}
+				for(VkPhysicalDevice device : devices){
+					if(deviceUuid(device) == uuid){
+						return device;
+					}
+				}
+				for(VkPhysicalDevice device : devices){
+					VkPhysicalDeviceProperties deviceProperties;
+					vkGetPhysicalDeviceProperties(device, &deviceProperties);
+					std::string name = deviceProperties.deviceName;
+					std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+					if(name.find(lowered) != std::string::npos){
+						return device;
+					}
+				}
+				throw std::runtime_error("no device matches " + wanted + "!");
+			}
 			
 			void createLogicalDevice(){
 				// Multiple queues need to be created
 				QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
 				std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-				std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+				std::set<uint32_t> uniqueQueueFamilies;
+				if(config.compute){
+					uniqueQueueFamilies = {indices.computeFamily.value()};
+				} else {
+					uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+				}
 
 				float queuePriority = 1.0f;
 				for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -389,8 +986,11 @@ const std::vector<const char*> deviceExtensions = {
 					queueCreateInfos.push_back(queueCreateInfo);
 				}
 
-				// Not interested in any features at the moment
+				// Counting shader invocations is the only feature we use, and it is optional.
+				VkPhysicalDeviceFeatures supportedFeatures;
+				vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
 				VkPhysicalDeviceFeatures deviceFeatures = {};
+				deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
 				
 				// Create a logical device
 				VkDeviceCreateInfo createInfo = {};
@@ -400,24 +1000,73 @@ const std::vector<const char*> deviceExtensions = {
 					static_cast<uint32_t>(queueCreateInfos.size());
 				createInfo.pEnabledFeatures = &deviceFeatures;
 				//info on extensions and validation layers
+				std::vector<const char*> extensions = requiredDeviceExtensions();
+
+				// Driver statistics for each pipeline, where the driver will give them.
+				VkPhysicalDevicePipelineExecutablePropertiesFeaturesKHR executableFeatures = {};
+				executableFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PIPELINE_EXECUTABLE_PROPERTIES_FEATURES_KHR;
+				auto getFeatures2 = (PFN_vkGetPhysicalDeviceFeatures2KHR) vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR");
+				if(hasProperties2 && getFeatures2 != nullptr &&
+						hasDeviceExtension(physicalDevice, VK_KHR_PIPELINE_EXECUTABLE_PROPERTIES_EXTENSION_NAME)){
+					VkPhysicalDeviceFeatures2 features2 = {};
+					features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+					features2.pNext = &executableFeatures;
+					getFeatures2(physicalDevice, &features2);
+					executableFeatures.pNext = nullptr;
+					if(executableFeatures.pipelineExecutableInfo){
+						hasExecutableProperties = true;
+						extensions.push_back(VK_KHR_PIPELINE_EXECUTABLE_PROPERTIES_EXTENSION_NAME);
+						createInfo.pNext = &executableFeatures;
+					}
+				}
 				createInfo.enabledExtensionCount =
-				   	static_cast<uint32_t>(deviceExtensions.size());
-				createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+				   	static_cast<uint32_t>(extensions.size());
+				createInfo.ppEnabledExtensionNames = extensions.data();
 
 				createInfo.enabledLayerCount = 
-					static_cast<uint32_t>(validationLayers.size());
-				createInfo.ppEnabledLayerNames = validationLayers.data();
+					static_cast<uint32_t>(layers.size());
+				createInfo.ppEnabledLayerNames = layers.data();
 				
 				if(vkCreateDevice(physicalDevice, &createInfo, nullptr, &lDevice) != VK_SUCCESS){
 					throw std::runtime_error("Creating logical GPU failed!");
 				}
+
+				if(hasExecutableProperties){
+					getPipelineExecutableProperties = (PFN_vkGetPipelineExecutablePropertiesKHR)
+						vkGetDeviceProcAddr(lDevice, "vkGetPipelineExecutablePropertiesKHR");
+					getPipelineExecutableStatistics = (PFN_vkGetPipelineExecutableStatisticsKHR)
+						vkGetDeviceProcAddr(lDevice, "vkGetPipelineExecutableStatisticsKHR");
+					getPipelineExecutableInternalRepresentations = (PFN_vkGetPipelineExecutableInternalRepresentationsKHR)
+						vkGetDeviceProcAddr(lDevice, "vkGetPipelineExecutableInternalRepresentationsKHR");
+				}
 			
+				// Compute mode only needs the compute queue
+				if(config.compute){
+					vkGetDeviceQueue(lDevice, indices.computeFamily.value(), 0, &computeQueue);
+					return;
+				}
+
 				//Get the graphics queue	
 				vkGetDeviceQueue(lDevice, indices.graphicsFamily.value(), 0, &graphicsQueue);
 
 				//Get the present queue
 				vkGetDeviceQueue(lDevice, indices.graphicsFamily.value(), 0, &presentQueue);	
 			}
+
+			// The family everything is submitted to, and timed on.
+			uint32_t workFamily(){
+				QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
+				return config.compute ? indices.computeFamily.value() : indices.graphicsFamily.value();
+			}
+
+			// Command buffers, and their queries, taken in turn: one per image, or in
+			// compute mode, where there are no images, as many as headless would have.
+			size_t frameSlotCount(){
+				if(config.compute){
+					return std::max<size_t>(OFFSCREEN_IMAGE_COUNT, config.framesInFlight);
+				}
+				return swapChainImages.size();
+			}
 			
 			struct SwapChainSupportDetails {
 				VkSurfaceCapabilitiesKHR capabilities;
@@ -492,7 +1141,7 @@ const std::vector<const char*> deviceExtensions = {
 					return capabilities.currentExtent;
 				} else {
 					// We have an incredibly large extent. We want to clamp it to the size of the window.
-					VkExtent2D actualExtent = {WIDTH, HEIGHT};
+					VkExtent2D actualExtent = {config.width, config.height};
 
 					actualExtent.width = std::max(capabilities.minImageExtent.width, std::min(capabilities.maxImageExtent.width, actualExtent.width));
 					actualExtent.height = std::max(capabilities.minImageExtent.height, std::min(capabilities.maxImageExtent.height, actualExtent.height));
@@ -507,6 +1156,7 @@ const std::vector<const char*> deviceExtensions = {
 				swapChainImageFormat = surfaceFormat.format;
 
 				VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+				swapChainPresentMode = presentMode;
 				VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 			swapChainExtent = extent;
 
@@ -558,6 +1208,73 @@ const std::vector<const char*> deviceExtensions = {
 
 			}
 
+			// Find a memory type that suits both the resource and what we want of it.
+			uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties){
+				VkPhysicalDeviceMemoryProperties memProperties;
+				vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+				for(uint32_t i = 0; i < memProperties.memoryTypeCount; i++){
+					if((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties){
+						return i;
+					}
+				}
+
+				throw std::runtime_error("failed to find suitable memory type!");
+			}
+
+			// Headless stand-in for the swapchain: device local images that are
+			// rendered to and never presented, so only the shader is measured.
+			void createOffscreenImages(VkExtent2D extent){
+				VkPhysicalDeviceProperties deviceProperties;
+				vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+				uint32_t maxSize = deviceProperties.limits.maxImageDimension2D;
+				if(extent.width == 0 || extent.height == 0 || extent.width > maxSize || extent.height > maxSize){
+					throw std::runtime_error("offscreen images must be between 1 and " + std::to_string(maxSize) + " pixels across!");
+				}
+
+				swapChainImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+				swapChainExtent = extent;
+
+				// At least one image per frame in flight, so frames never wait on each other.
+				uint32_t imageCount = std::max<uint32_t>(OFFSCREEN_IMAGE_COUNT, config.framesInFlight);
+				swapChainImages.resize(imageCount);
+				offscreenImageMemory.resize(imageCount);
+
+				for(size_t i = 0; i < swapChainImages.size(); i++){
+					VkImageCreateInfo imageInfo = {};
+					imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+					imageInfo.imageType = VK_IMAGE_TYPE_2D;
+					imageInfo.format = swapChainImageFormat;
+					imageInfo.extent = {swapChainExtent.width, swapChainExtent.height, 1};
+					imageInfo.mipLevels = 1;
+					imageInfo.arrayLayers = 1;
+					imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+					imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+					// Drawn to, and copied from should anyone want to look at it.
+					imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+					imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+					imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+					if (vkCreateImage(lDevice, &imageInfo, nullptr, &swapChainImages[i]) != VK_SUCCESS) {
+						throw std::runtime_error("failed to create offscreen image!");
+					}
+
+					VkMemoryRequirements memRequirements;
+					vkGetImageMemoryRequirements(lDevice, swapChainImages[i], &memRequirements);
+
+					VkMemoryAllocateInfo allocInfo = {};
+					allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+					allocInfo.allocationSize = memRequirements.size;
+					allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+					if (vkAllocateMemory(lDevice, &allocInfo, nullptr, &offscreenImageMemory[i]) != VK_SUCCESS) {
+						throw std::runtime_error("failed to allocate offscreen image memory!");
+					}
+
+					vkBindImageMemory(lDevice, swapChainImages[i], offscreenImageMemory[i], 0);
+				}
+			}
+
 			void createSurface() {
 				if(glfwCreateWindowSurface(instance, window, nullptr, &surface) != VK_SUCCESS){
 					throw std::runtime_error("failed to create window surface!");
@@ -617,7 +1334,8 @@ const std::vector<const char*> deviceExtensions = {
 				colourAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE; 	// No stencilling
 				colourAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;  // No stencilling
 				colourAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-				colourAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+				// Ready to present, or to copy out when there is nothing to present to.
+				colourAttachment.finalLayout = config.headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 				
 				// Subpass dependencies let us pipeline each frame.
 				VkSubpassDependency dependency = {};
@@ -656,9 +1374,139 @@ const std::vector<const char*> deviceExtensions = {
 				}
 			}
 
-			void createGraphicsPipeline(std::string shader){
+			// Load whatever this device and driver compiled last time. The file name
+			// is keyed on both, and the header is checked in case it was copied about.
+			void createPipelineCache(){
+				if(!config.pipelineCache){
+					return;
+				}
+
+				VkPhysicalDeviceProperties deviceProperties;
+				vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+
+				char name[64];
+				snprintf(name, sizeof(name), "/aule_%04x_%04x_%08x.cache", deviceProperties.vendorID,
+						deviceProperties.deviceID, deviceProperties.driverVersion);
+				pipelineCachePath = config.pipelineCacheDir + name;
+
+				std::vector<char> cacheData;
+				if(std::filesystem::exists(pipelineCachePath)){
+					cacheData = readFile(pipelineCachePath);
+					if(!isPipelineCacheValid(cacheData, deviceProperties)){
+						std::cout << "ignoring stale pipeline cache " << pipelineCachePath << std::endl;
+						cacheData.clear();
+					}
+				}
+
+				VkPipelineCacheCreateInfo cacheInfo = {};
+				cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+				cacheInfo.initialDataSize = cacheData.size();
+				cacheInfo.pInitialData = cacheData.data();
+
+				if (vkCreatePipelineCache(lDevice, &cacheInfo, nullptr, &pipelineCache) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create pipeline cache!");
+				}
+			}
+
+			// The header every pipeline cache starts with (VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+			bool isPipelineCacheValid(const std::vector<char>& cacheData, const VkPhysicalDeviceProperties& deviceProperties){
+				struct {
+					uint32_t headerSize;
+					uint32_t headerVersion;
+					uint32_t vendorID;
+					uint32_t deviceID;
+					uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+				} header;
+
+				if(cacheData.size() < sizeof(header)){
+					return false;
+				}
+				memcpy(&header, cacheData.data(), sizeof(header));
+
+				return header.headerSize >= sizeof(header) &&
+					header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+					header.vendorID == deviceProperties.vendorID &&
+					header.deviceID == deviceProperties.deviceID &&
+					memcmp(header.pipelineCacheUUID, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+			}
+
+			size_t pipelineCacheSize(){
+				size_t size = 0;
+				if(pipelineCache != VK_NULL_HANDLE){
+					vkGetPipelineCacheData(lDevice, pipelineCache, &size, nullptr);
+				}
+				return size;
+			}
+
+			void savePipelineCache(){
+				if(pipelineCache == VK_NULL_HANDLE){
+					return;
+				}
+
+				size_t size = pipelineCacheSize();
+				std::vector<char> cacheData(size);
+				vkGetPipelineCacheData(lDevice, pipelineCache, &size, cacheData.data());
+
+				// Written aside and renamed into place, as identical devices run
+				// side by side share the file. A cache that can't be saved only
+				// costs the next run its compile time, so teardown carries on.
+				std::string part = partPath(pipelineCachePath);
+				bool written;
+				{
+					std::ofstream cacheFile(part, std::ios::binary);
+					cacheFile.write(cacheData.data(), size);
+					cacheFile.close();
+					written = !cacheFile.fail();
+				}
+				std::error_code error;
+				if(written){
+					std::filesystem::rename(part, pipelineCachePath, error);
+				}
+				if(!written || error){
+					std::filesystem::remove(part, error);
+					std::cerr << "failed to save the pipeline cache to " << pipelineCachePath << std::endl;
+				}
+				vkDestroyPipelineCache(lDevice, pipelineCache, nullptr);
+			}
+
+			void createGraphicsPipeline(const std::string& shader){
+				VkPushConstantRange pushConstantRange = {VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(FrameInputs)};
+				// The frame inputs are set 0, the resources set 1.
+				VkDescriptorSetLayout setLayouts[] = {config.inputs ? inputsSetLayout : emptySetLayout, resourceSetLayout};
+				VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+				pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+				pipelineLayoutInfo.pSetLayouts = setLayouts;
+				if(config.inputs){
+					pipelineLayoutInfo.setLayoutCount = 1;
+					pipelineLayoutInfo.pushConstantRangeCount = 1;
+					pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+				}
+				if(!config.resources.empty()){
+					pipelineLayoutInfo.setLayoutCount = 2;
+				}
+
+				if (vkCreatePipelineLayout(lDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create pipeline layout!");
+				}
+
+				std::string report;
+				variantPipelines = buildGraphicsPipelines(shader, shaderHash, shaderStats, report);
+				std::cout << report << std::endl;
+				graphicsPipeline = variantPipelines[0];
+			}
+
+			// The pipelines alone, with the layout already made. Nothing here changes
+			// the frames being drawn, so watch mode builds them in the background,
+			// and the line saying how they were created is left to the caller.
+			std::vector<VkPipeline> buildGraphicsPipelines(const std::string& shader, uint64_t& hash, SpirvStats& stats, std::string& report){
+				// Both loaded before any modules are made, and the modules destroyed on every
+				// way out, so a shader that fails to build leaks nothing.
+				auto vertShaderCode = loadSpirv(config.vertexShader);
+				auto fragShaderCode = loadSpirv(shader);
+				hash = hashBytes(fragShaderCode.data(), fragShaderCode.size());
+				stats = analyzeSpirv(fragShaderCode);
+
 				//Vertex shader
-				auto vertShaderCode = readFile("./vert.spv");
 				VkShaderModule vertShader = createShaderModule(vertShaderCode);
 				
 				VkPipelineShaderStageCreateInfo vertShaderInfo = {};
@@ -668,8 +1516,13 @@ const std::vector<const char*> deviceExtensions = {
 				vertShaderInfo.pName = "main";
 				
 				//Fragment shader
-				auto fragShaderCode = readFile(shader);
-				VkShaderModule fragShader = createShaderModule(fragShaderCode);
+				VkShaderModule fragShader;
+				try {
+					fragShader = createShaderModule(fragShaderCode);
+				} catch(const std::exception&){
+					vkDestroyShaderModule(lDevice, vertShader, nullptr);
+					throw;
+				}
 				
 				VkPipelineShaderStageCreateInfo fragShaderInfo = {};
 				fragShaderInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -692,25 +1545,18 @@ const std::vector<const char*> deviceExtensions = {
 				inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 				inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-				// Create a viewport
-				VkViewport viewport = {};
-				viewport.x = 0.0f;
-				viewport.y = 0.0f;
-				viewport.width = (float) swapChainExtent.width;
-				viewport.height = (float) swapChainExtent.height;
-				viewport.minDepth = 0.0f;
-				viewport.maxDepth = 1.0f;
-
-				VkRect2D scissor = {};
-				scissor.offset = {0, 0};
-				scissor.extent = swapChainExtent;
-
+				// One viewport and scissor, set when recording so the pipeline
+				// outlives a change of size.
 				VkPipelineViewportStateCreateInfo viewportState = {};
 				viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 				viewportState.viewportCount = 1;
-				viewportState.pViewports = &viewport;
 				viewportState.scissorCount = 1;
-				viewportState.pScissors = &scissor;
+
+				VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+				VkPipelineDynamicStateCreateInfo dynamicState = {};
+				dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+				dynamicState.dynamicStateCount = 2;
+				dynamicState.pDynamicStates = dynamicStates;
 
 				//Rasteriser
 				
@@ -747,17 +1593,9 @@ const std::vector<const char*> deviceExtensions = {
 				colorBlending.attachmentCount = 1;
 				colorBlending.pAttachments = &colorBlendAttachment;
 
-				// Build the pipeline
-				VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-				pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-
-
-				if (vkCreatePipelineLayout(lDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
-					throw std::runtime_error("failed to create pipeline layout!");
-				}
-				
 				VkGraphicsPipelineCreateInfo pipelineInfo = {};
 				pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+				pipelineInfo.flags = captureFlags();
 				pipelineInfo.stageCount = 2;
 				pipelineInfo.pStages = shaderStages;
 				pipelineInfo.pVertexInputState = &vertexInputInfo;
@@ -766,59 +1604,990 @@ const std::vector<const char*> deviceExtensions = {
 				pipelineInfo.pRasterizationState = &rasterizer;
 				pipelineInfo.pMultisampleState = &multisampling;
 				pipelineInfo.pColorBlendState = &colorBlending;
+				pipelineInfo.pDynamicState = &dynamicState;
 
 				pipelineInfo.layout = pipelineLayout;
 				pipelineInfo.renderPass = renderPass;
 				pipelineInfo.subpass = 0;
 
-				if (vkCreateGraphicsPipelines(lDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
-					throw std::runtime_error("failed to create graphics pipeline!");
+				// Each variant differs only in the fragment shader's specialization.
+				std::vector<VkPipeline> pipelines;
+				try {
+					pipelines = createVariantPipelines(shader, report, [&](size_t v, VkPipeline* pipeline){
+						VkPipelineShaderStageCreateInfo variantStages[] = {vertShaderInfo, fragShaderInfo};
+						variantStages[1].pSpecializationInfo = &variants[v].info;
+						VkGraphicsPipelineCreateInfo variantInfo = pipelineInfo;
+						variantInfo.pStages = variantStages;
+						return vkCreateGraphicsPipelines(lDevice, pipelineCache, 1, &variantInfo, nullptr, pipeline);
+					});
+				} catch(const std::exception&){
+					vkDestroyShaderModule(lDevice, vertShader, nullptr);
+					vkDestroyShaderModule(lDevice, fragShader, nullptr);
+					throw;
 				}
 				
 				// Clean up the shaders.
 				vkDestroyShaderModule(lDevice, vertShader, nullptr);
 				vkDestroyShaderModule(lDevice, fragShader, nullptr);
+				return pipelines;
 			}
 			
-			void createFrameBuffers(){
-				swapChainFramebuffers.resize(swapChainImageViews.size());
+			// Compute shaders see the bindings in set 0, in the order they were given.
+			void createComputePipeline(const std::string& shader){
+				// The storage bindings are set 0, the frame inputs' uniform buffer set 1.
+				VkDescriptorSetLayout setLayouts[] = {computeSetLayout, inputsSetLayout};
+				VkPushConstantRange pushConstantRange = {VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(FrameInputs)};
+				VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+				pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+				pipelineLayoutInfo.setLayoutCount = 1;
+				pipelineLayoutInfo.pSetLayouts = setLayouts;
+				if(config.inputs){
+					pipelineLayoutInfo.setLayoutCount = 2;
+					pipelineLayoutInfo.pushConstantRangeCount = 1;
+					pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+				}
 
-				for(size_t i = 0; i < swapChainImageViews.size(); i++){
-					VkImageView attachments[] = {
-						swapChainImageViews[i]
-					};
+				if (vkCreatePipelineLayout(lDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create pipeline layout!");
+				}
 
-					VkFramebufferCreateInfo frameBufferInfo = {};
-					frameBufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-					frameBufferInfo.renderPass = renderPass;
-					frameBufferInfo.attachmentCount = 1;
-					frameBufferInfo.pAttachments = attachments;
-					frameBufferInfo.width = swapChainExtent.width;
-					frameBufferInfo.height = swapChainExtent.height;
-					frameBufferInfo.layers = 1;
+				std::string report;
+				variantPipelines = buildComputePipelines(shader, shaderHash, shaderStats, report);
+				std::cout << report << std::endl;
+				computePipeline = variantPipelines[0];
+			}
 
-					if (vkCreateFramebuffer(lDevice, &frameBufferInfo, nullptr, &swapChainFramebuffers[i]) != VK_SUCCESS) {
-						throw std::runtime_error("failed to create framebuffer!");
-					}
+			std::vector<VkPipeline> buildComputePipelines(const std::string& shader, uint64_t& hash, SpirvStats& stats, std::string& report){
+				auto compShaderCode = loadSpirv(shader);
+				hash = hashBytes(compShaderCode.data(), compShaderCode.size());
+				stats = analyzeSpirv(compShaderCode);
+				VkShaderModule compShader = createShaderModule(compShaderCode);
+
+				VkComputePipelineCreateInfo pipelineInfo = {};
+				pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+				pipelineInfo.flags = captureFlags();
+				pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+				pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+				pipelineInfo.stage.module = compShader;
+				pipelineInfo.stage.pName = "main";
+				pipelineInfo.layout = pipelineLayout;
+
+				std::vector<VkPipeline> pipelines;
+				try {
+					pipelines = createVariantPipelines(shader, report, [&](size_t v, VkPipeline* pipeline){
+						VkComputePipelineCreateInfo variantInfo = pipelineInfo;
+						variantInfo.stage.pSpecializationInfo = &variants[v].info;
+						return vkCreateComputePipelines(lDevice, pipelineCache, 1, &variantInfo, nullptr, pipeline);
+					});
+				} catch(const std::exception&){
+					vkDestroyShaderModule(lDevice, compShader, nullptr);
+					throw;
 				}
+
+				vkDestroyShaderModule(lDevice, compShader, nullptr);
+				return pipelines;
 			}
 
-			void createCommandPool(){
-				QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
+			// Ask the driver to keep what it can tell us about each pipeline.
+			VkPipelineCreateFlags captureFlags(){
+				if(!hasExecutableProperties){
+					return 0;
+				}
+				VkPipelineCreateFlags flags = VK_PIPELINE_CREATE_CAPTURE_STATISTICS_BIT_KHR;
+				if(config.executableIr){
+					flags |= VK_PIPELINE_CREATE_CAPTURE_INTERNAL_REPRESENTATIONS_BIT_KHR;
+				}
+				return flags;
+			}
 
-				VkCommandPoolCreateInfo poolInfo = {};
-				poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-				poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+			// Every statistic of every executable in the pipeline. With
+			// --executable-ir, each internal representation goes to
+			// <shader>.<executable>.<representation>.txt as well.
+			std::vector<PipelineExecutable> queryPipelineExecutables(VkPipeline pipeline, const std::string& shader){
+				std::vector<PipelineExecutable> executables;
+				if(!hasExecutableProperties){
+					return executables;
+				}
 
-				if (vkCreateCommandPool(lDevice, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
-					throw std::runtime_error("failed to create command pool!");
+				VkPipelineInfoKHR pipelineInfo = {};
+				pipelineInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INFO_KHR;
+				pipelineInfo.pipeline = pipeline;
+				uint32_t executableCount = 0;
+				getPipelineExecutableProperties(lDevice, &pipelineInfo, &executableCount, nullptr);
+				std::vector<VkPipelineExecutablePropertiesKHR> properties(executableCount);
+				for(auto& property : properties){
+					property = {};
+					property.sType = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_PROPERTIES_KHR;
 				}
+				getPipelineExecutableProperties(lDevice, &pipelineInfo, &executableCount, properties.data());
+
+				for(uint32_t i = 0; i < executableCount; i++){
+					PipelineExecutable executable;
+					executable.name = properties[i].name;
+					executable.description = properties[i].description;
+					executable.stages = properties[i].stages;
+					executable.subgroupSize = properties[i].subgroupSize;
+
+					VkPipelineExecutableInfoKHR executableInfo = {};
+					executableInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_INFO_KHR;
+					executableInfo.pipeline = pipeline;
+					executableInfo.executableIndex = i;
+
+					uint32_t statisticCount = 0;
+					getPipelineExecutableStatistics(lDevice, &executableInfo, &statisticCount, nullptr);
+					std::vector<VkPipelineExecutableStatisticKHR> statistics(statisticCount);
+					for(auto& statistic : statistics){
+						statistic = {};
+						statistic.sType = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_STATISTIC_KHR;
+					}
+					getPipelineExecutableStatistics(lDevice, &executableInfo, &statisticCount, statistics.data());
+					for(const auto& statistic : statistics){
+						std::string value;
+						switch(statistic.format){
+							case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_BOOL32_KHR: value = statistic.value.b32 ? "true" : "false"; break;
+							case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_INT64_KHR: value = std::to_string(statistic.value.i64); break;
+							case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_UINT64_KHR: value = std::to_string(statistic.value.u64); break;
+							default: value = jsonNumber(statistic.value.f64); break;
+						}
+						executable.statistics.push_back({statistic.name, value});
+					}
+
+					if(config.executableIr){
+						writeInternalRepresentations(executableInfo, shader + "." + std::to_string(i));
+					}
+					executables.push_back(executable);
+				}
+				return executables;
 			}
 
+			// Sizes first, then the data into buffers of those sizes.
+			void writeInternalRepresentations(const VkPipelineExecutableInfoKHR& executableInfo, const std::string& prefix){
+				uint32_t count = 0;
+				getPipelineExecutableInternalRepresentations(lDevice, &executableInfo, &count, nullptr);
+				std::vector<VkPipelineExecutableInternalRepresentationKHR> representations(count);
+				for(auto& representation : representations){
+					representation = {};
+					representation.sType = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_INTERNAL_REPRESENTATION_KHR;
+				}
+				getPipelineExecutableInternalRepresentations(lDevice, &executableInfo, &count, representations.data());
 
-			void createCommandBuffers() {
+				std::vector<std::vector<char>> data(count);
+				for(uint32_t r = 0; r < count; r++){
+					data[r].resize(representations[r].dataSize);
+					representations[r].pData = data[r].data();
+				}
+				getPipelineExecutableInternalRepresentations(lDevice, &executableInfo, &count, representations.data());
+
+				for(uint32_t r = 0; r < count; r++){
+					std::string name = representations[r].name;
+					std::replace_if(name.begin(), name.end(), [](char c){ return !std::isalnum(static_cast<unsigned char>(c)); }, '_');
+					std::ofstream file(prefix + "." + name + (representations[r].isText ? ".txt" : ".bin"), std::ios::binary);
+					// Text comes with its terminating null.
+					size_t size = representations[r].dataSize;
+					if(representations[r].isText && size > 0 && data[r][size - 1] == '\0'){
+						size--;
+					}
+					file.write(data[r].data(), size);
+				}
+			}
+
+			// A pipeline per variant. Independent pipelines compile in parallel on
+			// most drivers, and the pipeline cache looks after its own locking, so
+			// the variants are shared out over a thread per core. How long they
+			// took goes in the report rather than out, as this may be off the main thread.
+			std::vector<VkPipeline> createVariantPipelines(const std::string& shader, std::string& report,
+					const std::function<VkResult(size_t, VkPipeline*)>& createOne){
+				// A cache that grows while creating the pipeline didn't have it.
+				size_t cacheSizeBefore = pipelineCacheSize();
+				auto compileStart = std::chrono::steady_clock::now();
+
+				std::vector<VkPipeline> pipelines(variants.size(), VK_NULL_HANDLE);
+				std::vector<VkResult> results(variants.size(), VK_SUCCESS);
+				size_t threadCount = std::min<size_t>(variants.size(), std::max(1u, std::thread::hardware_concurrency()));
+				std::vector<std::thread> threads;
+				for(size_t t = 0; t < threadCount; t++){
+					threads.emplace_back([&, t](){
+						for(size_t v = t; v < variants.size(); v += threadCount){
+							results[v] = createOne(v, &pipelines[v]);
+						}
+					});
+				}
+				for(std::thread& thread : threads){
+					thread.join();
+				}
+				for(VkResult result : results){
+					if(result != VK_SUCCESS){
+						for(VkPipeline pipeline : pipelines){
+							vkDestroyPipeline(lDevice, pipeline, nullptr);
+						}
+						throw std::runtime_error("failed to create pipeline!");
+					}
+				}
+
+				float compileTime_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - compileStart).count();
+				std::ostringstream line;
+				line << named(shader) << ": ";
+				if(variants.size() > 1){
+					line << variants.size() << " pipelines created in " << compileTime_ms << " ms on " << threadCount << " threads";
+				} else {
+					line << "pipeline created in " << compileTime_ms << " ms";
+				}
+				if(pipelineCache != VK_NULL_HANDLE){
+					line << (pipelineCacheSize() > cacheSizeBefore ? " (cache miss)" : " (cache hit)");
+				}
+				report = line.str();
+				return pipelines;
+			}
+
+			// Every combination of the specialization constants' values, the last
+			// constant changing fastest.
+			void makeVariants(){
+				variants.assign(1, Variant());
+				for(const SpecConstant& constant : config.specConstants){
+					std::vector<Variant> combined;
+					for(const Variant& variant : variants){
+						for(size_t i = 0; i < constant.values.size(); i++){
+							Variant next = variant;
+							next.name += (next.name.empty() ? "" : "_") + std::to_string(constant.id) + "=" + constant.names[i];
+							next.entries.push_back({constant.id, static_cast<uint32_t>(next.data.size() * sizeof(uint32_t)), sizeof(uint32_t)});
+							next.data.push_back(constant.values[i]);
+							combined.push_back(next);
+						}
+					}
+					variants = combined;
+				}
+
+				// Only now the vectors have stopped moving.
+				for(Variant& variant : variants){
+					variant.info.mapEntryCount = static_cast<uint32_t>(variant.entries.size());
+					variant.info.pMapEntries = variant.entries.data();
+					variant.info.dataSize = variant.data.size() * sizeof(uint32_t);
+					variant.info.pData = variant.data.data();
+				}
+			}
+
+			// One host visible uniform buffer per frame in flight, so the CPU writes
+			// one while the GPU may still be reading the others. The frame inputs
+			// go at the start, the parameter block after them, written once.
+			void createInputBuffers(){
+				std::vector<char> params;
+				if(!config.paramsFile.empty()){
+					params = readFile(config.paramsFile);
+				}
+				VkDeviceSize blockSize = UNIFORM_PARAMS_OFFSET + params.size();
+
+				// The whole block is bound as one uniform buffer range
+				VkPhysicalDeviceProperties deviceProperties;
+				vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+				if(blockSize > deviceProperties.limits.maxUniformBufferRange){
+					throw std::runtime_error("parameter block of " + std::to_string(params.size()) + " bytes is over the device's uniform buffer range of "
+						+ std::to_string(deviceProperties.limits.maxUniformBufferRange - UNIFORM_PARAMS_OFFSET) + "!");
+				}
+
+				VkShaderStageFlags stages = config.compute ? VK_SHADER_STAGE_COMPUTE_BIT : VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+				VkDescriptorSetLayoutBinding binding = {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, stages, nullptr};
+				VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+				layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+				layoutInfo.bindingCount = 1;
+				layoutInfo.pBindings = &binding;
+				if (vkCreateDescriptorSetLayout(lDevice, &layoutInfo, nullptr, &inputsSetLayout) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create descriptor set layout!");
+				}
+
+				VkDescriptorPoolSize poolSize = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, config.framesInFlight};
+				VkDescriptorPoolCreateInfo poolInfo = {};
+				poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+				poolInfo.maxSets = config.framesInFlight;
+				poolInfo.poolSizeCount = 1;
+				poolInfo.pPoolSizes = &poolSize;
+				if (vkCreateDescriptorPool(lDevice, &poolInfo, nullptr, &inputsDescriptorPool) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create descriptor pool!");
+				}
+
+				std::vector<VkDescriptorSetLayout> layouts(config.framesInFlight, inputsSetLayout);
+				VkDescriptorSetAllocateInfo allocInfo = {};
+				allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+				allocInfo.descriptorPool = inputsDescriptorPool;
+				allocInfo.descriptorSetCount = config.framesInFlight;
+				allocInfo.pSetLayouts = layouts.data();
+				inputsDescriptorSets.resize(config.framesInFlight);
+				if (vkAllocateDescriptorSets(lDevice, &allocInfo, inputsDescriptorSets.data()) != VK_SUCCESS) {
+					throw std::runtime_error("failed to allocate descriptor sets!");
+				}
+
+				inputsBuffers.resize(config.framesInFlight);
+				inputsMemory.resize(config.framesInFlight);
+				inputsMapped.resize(config.framesInFlight);
+				for(size_t i = 0; i < config.framesInFlight; i++){
+					VkBufferCreateInfo bufferInfo = {};
+					bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+					bufferInfo.size = blockSize;
+					bufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+					bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+					if (vkCreateBuffer(lDevice, &bufferInfo, nullptr, &inputsBuffers[i]) != VK_SUCCESS) {
+						throw std::runtime_error("failed to create uniform buffer!");
+					}
+
+					VkMemoryRequirements memRequirements;
+					vkGetBufferMemoryRequirements(lDevice, inputsBuffers[i], &memRequirements);
+					VkMemoryAllocateInfo memoryInfo = {};
+					memoryInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+					memoryInfo.allocationSize = memRequirements.size;
+					memoryInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits,
+							VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+					if (vkAllocateMemory(lDevice, &memoryInfo, nullptr, &inputsMemory[i]) != VK_SUCCESS) {
+						throw std::runtime_error("failed to allocate uniform buffer memory!");
+					}
+					vkBindBufferMemory(lDevice, inputsBuffers[i], inputsMemory[i], 0);
+
+					void* mapped;
+					vkMapMemory(lDevice, inputsMemory[i], 0, blockSize, 0, &mapped);
+					inputsMapped[i] = static_cast<char*>(mapped);
+					memset(inputsMapped[i], 0, UNIFORM_PARAMS_OFFSET);
+					if(!params.empty()){
+						memcpy(inputsMapped[i] + UNIFORM_PARAMS_OFFSET, params.data(), params.size());
+					}
+
+					VkDescriptorBufferInfo descriptorBuffer = {inputsBuffers[i], 0, blockSize};
+					VkWriteDescriptorSet write = {};
+					write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+					write.dstSet = inputsDescriptorSets[i];
+					write.dstBinding = 0;
+					write.descriptorCount = 1;
+					write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+					write.pBufferInfo = &descriptorBuffer;
+					vkUpdateDescriptorSets(lDevice, 1, &write, 0, nullptr);
+				}
+			}
+
+			// Device local storage buffers and images for the compute bindings, and
+			// the descriptor set that points at them. Images are moved to the general
+			// layout once, and stay there.
+			void createComputeResources(){
+				std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
+				uint32_t storageBufferCount = 0;
+				uint32_t storageImageCount = 0;
+				for(uint32_t i = 0; i < config.bindings.size(); i++){
+					VkDescriptorSetLayoutBinding binding = {};
+					binding.binding = i;
+					binding.descriptorType = config.bindings[i].image ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+					binding.descriptorCount = 1;
+					binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+					layoutBindings.push_back(binding);
+					config.bindings[i].image ? storageImageCount++ : storageBufferCount++;
+				}
+
+				VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+				layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+				layoutInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
+				layoutInfo.pBindings = layoutBindings.data();
+				if (vkCreateDescriptorSetLayout(lDevice, &layoutInfo, nullptr, &computeSetLayout) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create descriptor set layout!");
+				}
+
+				// An empty set 0 still keeps the frame inputs at set 1.
+				if(config.bindings.empty()){
+					return;
+				}
+
+				std::vector<VkDescriptorPoolSize> poolSizes;
+				if(storageBufferCount > 0){
+					poolSizes.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, storageBufferCount});
+				}
+				if(storageImageCount > 0){
+					poolSizes.push_back({VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, storageImageCount});
+				}
+				VkDescriptorPoolCreateInfo poolInfo = {};
+				poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+				poolInfo.maxSets = 1;
+				poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+				poolInfo.pPoolSizes = poolSizes.data();
+				if (vkCreateDescriptorPool(lDevice, &poolInfo, nullptr, &computeDescriptorPool) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create descriptor pool!");
+				}
+
+				VkDescriptorSetAllocateInfo allocInfo = {};
+				allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+				allocInfo.descriptorPool = computeDescriptorPool;
+				allocInfo.descriptorSetCount = 1;
+				allocInfo.pSetLayouts = &computeSetLayout;
+				if (vkAllocateDescriptorSets(lDevice, &allocInfo, &computeDescriptorSet) != VK_SUCCESS) {
+					throw std::runtime_error("failed to allocate descriptor set!");
+				}
+
+				// The resources themselves, and what each descriptor points at.
+				std::vector<VkDescriptorBufferInfo> bufferInfos(config.bindings.size());
+				std::vector<VkDescriptorImageInfo> imageInfos(config.bindings.size());
+				std::vector<VkWriteDescriptorSet> writes;
+				for(uint32_t i = 0; i < config.bindings.size(); i++){
+					VkMemoryRequirements memRequirements;
+					VkWriteDescriptorSet write = {};
+					write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+					write.dstSet = computeDescriptorSet;
+					write.dstBinding = i;
+					write.descriptorCount = 1;
+					write.descriptorType = layoutBindings[i].descriptorType;
+
+					if(config.bindings[i].image){
+						VkImageCreateInfo imageInfo = {};
+						imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+						imageInfo.imageType = VK_IMAGE_TYPE_2D;
+						imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+						imageInfo.extent = {config.bindings[i].extent.width, config.bindings[i].extent.height, 1};
+						imageInfo.mipLevels = 1;
+						imageInfo.arrayLayers = 1;
+						imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+						imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+						imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT;
+						imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+						imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+						VkImage image;
+						if (vkCreateImage(lDevice, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+							throw std::runtime_error("failed to create storage image!");
+						}
+						computeImages.push_back(image);
+						vkGetImageMemoryRequirements(lDevice, image, &memRequirements);
+					} else {
+						VkBufferCreateInfo bufferInfo = {};
+						bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+						bufferInfo.size = config.bindings[i].size;
+						bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+						bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+						VkBuffer buffer;
+						if (vkCreateBuffer(lDevice, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+							throw std::runtime_error("failed to create storage buffer!");
+						}
+						computeBuffers.push_back(buffer);
+						vkGetBufferMemoryRequirements(lDevice, buffer, &memRequirements);
+					}
+
+					VkMemoryAllocateInfo memoryInfo = {};
+					memoryInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+					memoryInfo.allocationSize = memRequirements.size;
+					memoryInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+					VkDeviceMemory memory;
+					if (vkAllocateMemory(lDevice, &memoryInfo, nullptr, &memory) != VK_SUCCESS) {
+						throw std::runtime_error("failed to allocate storage memory!");
+					}
+					computeMemory.push_back(memory);
+
+					if(config.bindings[i].image){
+						vkBindImageMemory(lDevice, computeImages.back(), memory, 0);
+
+						VkImageViewCreateInfo viewInfo = {};
+						viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+						viewInfo.image = computeImages.back();
+						viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+						viewInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+						viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+						VkImageView view;
+						if (vkCreateImageView(lDevice, &viewInfo, nullptr, &view) != VK_SUCCESS) {
+							throw std::runtime_error("failed to create storage image view!");
+						}
+						computeImageViews.push_back(view);
+
+						imageInfos[i] = {VK_NULL_HANDLE, view, VK_IMAGE_LAYOUT_GENERAL};
+						write.pImageInfo = &imageInfos[i];
+					} else {
+						vkBindBufferMemory(lDevice, computeBuffers.back(), memory, 0);
+						bufferInfos[i] = {computeBuffers.back(), 0, VK_WHOLE_SIZE};
+						write.pBufferInfo = &bufferInfos[i];
+					}
+					writes.push_back(write);
+				}
+				vkUpdateDescriptorSets(lDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+				// Move the images into the general layout, waiting for it to happen.
+				if(computeImages.empty()){
+					return;
+				}
+				VkCommandBufferAllocateInfo commandInfo = {};
+				commandInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+				commandInfo.commandPool = commandPool;
+				commandInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+				commandInfo.commandBufferCount = 1;
+				VkCommandBuffer commandBuffer;
+				vkAllocateCommandBuffers(lDevice, &commandInfo, &commandBuffer);
+
+				VkCommandBufferBeginInfo beginInfo = {};
+				beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+				beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+				vkBeginCommandBuffer(commandBuffer, &beginInfo);
+				for(VkImage image : computeImages){
+					VkImageMemoryBarrier barrier = {};
+					barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+					barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+					barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+					barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					barrier.image = image;
+					barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+					barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+					vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+							0, 0, nullptr, 0, nullptr, 1, &barrier);
+				}
+				vkEndCommandBuffer(commandBuffer);
+
+				VkSubmitInfo submitInfo = {};
+				submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+				submitInfo.commandBufferCount = 1;
+				submitInfo.pCommandBuffers = &commandBuffer;
+				vkQueueSubmit(computeQueue, 1, &submitInfo, VK_NULL_HANDLE);
+				vkQueueWaitIdle(computeQueue);
+				vkFreeCommandBuffers(lDevice, commandPool, 1, &commandBuffer);
+			}
+
+			// Device local textures and storage buffers for the fragment shaders, each
+			// filled once from its own staging buffer. Mips below the first are
+			// blitted down from the level above, and textures are left in the shader
+			// read only layout for good.
+			void createResources(){
+				VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+				layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+				if(!config.inputs){
+					if (vkCreateDescriptorSetLayout(lDevice, &layoutInfo, nullptr, &emptySetLayout) != VK_SUCCESS) {
+						throw std::runtime_error("failed to create descriptor set layout!");
+					}
+				}
+
+				std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
+				uint32_t textureCount = 0;
+				uint32_t storageBufferCount = 0;
+				for(uint32_t i = 0; i < config.resources.size(); i++){
+					VkDescriptorSetLayoutBinding binding = {};
+					binding.binding = i;
+					binding.descriptorType = config.resources[i].texture ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+					binding.descriptorCount = 1;
+					binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+					layoutBindings.push_back(binding);
+					config.resources[i].texture ? textureCount++ : storageBufferCount++;
+				}
+				layoutInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
+				layoutInfo.pBindings = layoutBindings.data();
+				if (vkCreateDescriptorSetLayout(lDevice, &layoutInfo, nullptr, &resourceSetLayout) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create descriptor set layout!");
+				}
+
+				std::vector<VkDescriptorPoolSize> poolSizes;
+				if(textureCount > 0){
+					poolSizes.push_back({VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, textureCount});
+				}
+				if(storageBufferCount > 0){
+					poolSizes.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, storageBufferCount});
+				}
+				VkDescriptorPoolCreateInfo poolInfo = {};
+				poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+				poolInfo.maxSets = 1;
+				poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+				poolInfo.pPoolSizes = poolSizes.data();
+				if (vkCreateDescriptorPool(lDevice, &poolInfo, nullptr, &resourceDescriptorPool) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create descriptor pool!");
+				}
+
+				VkDescriptorSetAllocateInfo allocInfo = {};
+				allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+				allocInfo.descriptorPool = resourceDescriptorPool;
+				allocInfo.descriptorSetCount = 1;
+				allocInfo.pSetLayouts = &resourceSetLayout;
+				if (vkAllocateDescriptorSets(lDevice, &allocInfo, &resourceDescriptorSet) != VK_SUCCESS) {
+					throw std::runtime_error("failed to allocate descriptor set!");
+				}
+
+				// One command buffer does every upload.
+				VkCommandBufferAllocateInfo commandInfo = {};
+				commandInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+				commandInfo.commandPool = commandPool;
+				commandInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+				commandInfo.commandBufferCount = 1;
+				VkCommandBuffer commandBuffer;
+				vkAllocateCommandBuffers(lDevice, &commandInfo, &commandBuffer);
+
+				VkCommandBufferBeginInfo beginInfo = {};
+				beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+				beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+				vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+				std::vector<VkBuffer> stagingBuffers(config.resources.size());
+				std::vector<VkDeviceMemory> stagingMemories(config.resources.size());
+				std::vector<VkDescriptorBufferInfo> bufferInfos(config.resources.size());
+				std::vector<VkDescriptorImageInfo> imageInfos(config.resources.size());
+				std::vector<VkWriteDescriptorSet> writes;
+				for(uint32_t i = 0; i < config.resources.size(); i++){
+					const ResourceBinding& resource = config.resources[i];
+					std::vector<uint8_t> contents = resource.texture ? textureContents(resource) : bufferContents(resource);
+
+					void* mapped;
+					createHostBuffer(contents.size(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, stagingBuffers[i], stagingMemories[i], mapped);
+					memcpy(mapped, contents.data(), contents.size());
+
+					VkWriteDescriptorSet write = {};
+					write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+					write.dstSet = resourceDescriptorSet;
+					write.dstBinding = i;
+					write.descriptorCount = 1;
+					write.descriptorType = layoutBindings[i].descriptorType;
+					if(resource.texture){
+						VkImageView view;
+						VkSampler sampler;
+						createTexture(resource, commandBuffer, stagingBuffers[i], view, sampler);
+						imageInfos[i] = {sampler, view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+						write.pImageInfo = &imageInfos[i];
+					} else {
+						VkBuffer buffer = createDeviceBuffer(resource.size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+						VkBufferCopy copy = {0, 0, resource.size};
+						vkCmdCopyBuffer(commandBuffer, stagingBuffers[i], buffer, 1, &copy);
+						bufferInfos[i] = {buffer, 0, VK_WHOLE_SIZE};
+						write.pBufferInfo = &bufferInfos[i];
+					}
+					writes.push_back(write);
+				}
+				vkUpdateDescriptorSets(lDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+				// Buffers are read by the shaders after the copies, like the textures.
+				VkMemoryBarrier barrier = {};
+				barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+				vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+						VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+				vkEndCommandBuffer(commandBuffer);
+
+				VkSubmitInfo submitInfo = {};
+				submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+				submitInfo.commandBufferCount = 1;
+				submitInfo.pCommandBuffers = &commandBuffer;
+				vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+				vkQueueWaitIdle(graphicsQueue);
+				vkFreeCommandBuffers(lDevice, commandPool, 1, &commandBuffer);
+
+				for(size_t i = 0; i < stagingBuffers.size(); i++){
+					vkDestroyBuffer(lDevice, stagingBuffers[i], nullptr);
+					vkFreeMemory(lDevice, stagingMemories[i], nullptr);
+				}
+			}
+
+			// The largest mip's texels, packed in the texture's format.
+			std::vector<uint8_t> textureContents(const ResourceBinding& resource){
+				std::vector<float> rgba;
+				if(std::filesystem::path(resource.data).extension() == ".ppm"){
+					uint32_t width, height;
+					std::vector<uint8_t> pixels = readPpm(resource.data, width, height);
+					rgba.resize(pixels.size());
+					for(size_t i = 0; i < pixels.size(); i++){
+						rgba[i] = pixels[i] / 255.0f;
+					}
+				} else {
+					rgba = makePattern(resource.data, resource.extent.width, resource.extent.height, config.seed);
+				}
+				const TextureFormat& format = textureFormat(resource.format);
+				return packTexels(rgba, format.channels, format.bytesPerChannel);
+			}
+
+			// A file's bytes, or noise (floats in 0..1), a ramp (uints counting up
+			// from 0, handy as indices) or zeros.
+			std::vector<uint8_t> bufferContents(const ResourceBinding& resource){
+				if(resource.data != "noise" && resource.data != "ramp" && resource.data != "zero"){
+					// Cut short or padded with zeros to the buffer's size.
+					std::vector<char> bytes = readFile(resource.data);
+					std::vector<uint8_t> contents(bytes.begin(), bytes.end());
+					contents.resize(resource.size, 0);
+					return contents;
+				}
+				std::vector<uint8_t> contents(resource.size, 0);
+				std::mt19937 random(config.seed);
+				std::uniform_real_distribution<float> noise(0.0f, 1.0f);
+				for(size_t offset = 0; offset + 4 <= contents.size(); offset += 4){
+					if(resource.data == "noise"){
+						float value = noise(random);
+						memcpy(&contents[offset], &value, 4);
+					} else if(resource.data == "ramp"){
+						uint32_t value = static_cast<uint32_t>(offset / 4);
+						memcpy(&contents[offset], &value, 4);
+					}
+				}
+				return contents;
+			}
+
+			VkBuffer createDeviceBuffer(VkDeviceSize size, VkBufferUsageFlags usage){
+				VkBufferCreateInfo bufferInfo = {};
+				bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+				bufferInfo.size = size;
+				bufferInfo.usage = usage;
+				bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+				VkBuffer buffer;
+				if (vkCreateBuffer(lDevice, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create storage buffer!");
+				}
+				resourceBuffers.push_back(buffer);
+
+				VkMemoryRequirements memRequirements;
+				vkGetBufferMemoryRequirements(lDevice, buffer, &memRequirements);
+				VkMemoryAllocateInfo memoryInfo = {};
+				memoryInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+				memoryInfo.allocationSize = memRequirements.size;
+				memoryInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+				VkDeviceMemory memory;
+				if (vkAllocateMemory(lDevice, &memoryInfo, nullptr, &memory) != VK_SUCCESS) {
+					throw std::runtime_error("failed to allocate storage buffer memory!");
+				}
+				resourceMemory.push_back(memory);
+				vkBindBufferMemory(lDevice, buffer, memory, 0);
+				return buffer;
+			}
+
+			// The image, its view and sampler, and the commands that fill it from
+			// the staging buffer and leave it ready to sample.
+			void createTexture(const ResourceBinding& resource, VkCommandBuffer commandBuffer, VkBuffer staging, VkImageView& view, VkSampler& sampler){
+				uint32_t width = resource.extent.width;
+				uint32_t height = resource.extent.height;
+				uint32_t fullChain = 1;
+				while((std::max(width, height) >> fullChain) > 0){
+					fullChain++;
+				}
+				uint32_t mipLevels = resource.mipLevels == 0 ? fullChain : std::min(resource.mipLevels, fullChain);
+
+				// What the format can do with this tiling.
+				VkFormatProperties formatProperties;
+				vkGetPhysicalDeviceFormatProperties(physicalDevice, resource.format, &formatProperties);
+				VkFormatFeatureFlags features = resource.tiling == VK_IMAGE_TILING_OPTIMAL ?
+					formatProperties.optimalTilingFeatures : formatProperties.linearTilingFeatures;
+				std::string name = textureFormat(resource.format).name;
+				if(!(features & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)){
+					throw std::runtime_error(name + " textures can't be sampled with this tiling on this device!");
+				}
+				if(resource.filter == VK_FILTER_LINEAR && !(features & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)){
+					throw std::runtime_error(name + " textures can't be filtered linearly on this device!");
+				}
+				VkFormatFeatureFlags blit = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+				if(mipLevels > 1 && ((features & blit) != blit || !(features & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))){
+					throw std::runtime_error("mips of " + name + " textures can't be made by blitting on this device!");
+				}
+
+				// Copied into, and blitted from only to make mips.
+				VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+				if(mipLevels > 1){
+					usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+				}
+
+				// And whether an image this size, with these mips, can be made at all.
+				VkImageFormatProperties imageProperties;
+				std::string texture = name + " " + (resource.tiling == VK_IMAGE_TILING_LINEAR ? "linear" : "optimal") + " textures";
+				if(vkGetPhysicalDeviceImageFormatProperties(physicalDevice, resource.format, VK_IMAGE_TYPE_2D, resource.tiling,
+						usage, 0, &imageProperties) != VK_SUCCESS){
+					throw std::runtime_error(texture + " can't be uploaded and sampled on this device!");
+				}
+				if(width > imageProperties.maxExtent.width || height > imageProperties.maxExtent.height){
+					throw std::runtime_error(texture + " can be at most " + std::to_string(imageProperties.maxExtent.width) + "x" +
+							std::to_string(imageProperties.maxExtent.height) + " on this device!");
+				}
+				if(mipLevels > imageProperties.maxMipLevels){
+					throw std::runtime_error(texture + " can have at most " + std::to_string(imageProperties.maxMipLevels) + " mips on this device!");
+				}
+
+				VkImageCreateInfo imageInfo = {};
+				imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+				imageInfo.imageType = VK_IMAGE_TYPE_2D;
+				imageInfo.format = resource.format;
+				imageInfo.extent = {width, height, 1};
+				imageInfo.mipLevels = mipLevels;
+				imageInfo.arrayLayers = 1;
+				imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+				imageInfo.tiling = resource.tiling;
+				imageInfo.usage = usage;
+				imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+				imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				VkImage image;
+				if (vkCreateImage(lDevice, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create texture!");
+				}
+				resourceImages.push_back(image);
+
+				VkMemoryRequirements memRequirements;
+				vkGetImageMemoryRequirements(lDevice, image, &memRequirements);
+				VkMemoryAllocateInfo memoryInfo = {};
+				memoryInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+				memoryInfo.allocationSize = memRequirements.size;
+				memoryInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+				VkDeviceMemory memory;
+				if (vkAllocateMemory(lDevice, &memoryInfo, nullptr, &memory) != VK_SUCCESS) {
+					throw std::runtime_error("failed to allocate texture memory!");
+				}
+				resourceMemory.push_back(memory);
+				vkBindImageMemory(lDevice, image, memory, 0);
+
+				// Every level ready to be written, then the first one copied in.
+				VkImageMemoryBarrier barrier = {};
+				barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.image = image;
+				barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1};
+				vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+						0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+				VkBufferImageCopy copy = {};
+				copy.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+				copy.imageExtent = {width, height, 1};
+				vkCmdCopyBufferToImage(commandBuffer, staging, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+
+				// Each level in turn becomes the source for the next, then is done.
+				barrier.subresourceRange.levelCount = 1;
+				for(uint32_t level = 1; level < mipLevels; level++){
+					barrier.subresourceRange.baseMipLevel = level - 1;
+					barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+					barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+					barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+					barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+					vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+							0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+					VkImageBlit region = {};
+					region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1};
+					region.srcOffsets[1] = {int32_t(std::max(width >> (level - 1), 1u)), int32_t(std::max(height >> (level - 1), 1u)), 1};
+					region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+					region.dstOffsets[1] = {int32_t(std::max(width >> level, 1u)), int32_t(std::max(height >> level, 1u)), 1};
+					vkCmdBlitImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+							1, &region, VK_FILTER_LINEAR);
+
+					barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+					barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+					barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+					barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+					vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+							VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+				}
+				barrier.subresourceRange.baseMipLevel = mipLevels - 1;
+				barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+				vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+						VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+				VkImageViewCreateInfo viewInfo = {};
+				viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+				viewInfo.image = image;
+				viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+				viewInfo.format = resource.format;
+				viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1};
+				if (vkCreateImageView(lDevice, &viewInfo, nullptr, &view) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create texture view!");
+				}
+				resourceImageViews.push_back(view);
+
+				// Repeating, so shaders can scale their coordinates freely.
+				VkSamplerCreateInfo samplerInfo = {};
+				samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+				samplerInfo.magFilter = resource.filter;
+				samplerInfo.minFilter = resource.filter;
+				samplerInfo.mipmapMode = resource.filter == VK_FILTER_LINEAR ? VK_SAMPLER_MIPMAP_MODE_LINEAR : VK_SAMPLER_MIPMAP_MODE_NEAREST;
+				samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+				samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+				samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+				samplerInfo.maxLod = float(mipLevels);
+				if (vkCreateSampler(lDevice, &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create sampler!");
+				}
+				resourceSamplers.push_back(sampler);
+			}
+
+			void createFrameBuffers(){
+				swapChainFramebuffers.resize(swapChainImageViews.size());
+
+				for(size_t i = 0; i < swapChainImageViews.size(); i++){
+					VkImageView attachments[] = {
+						swapChainImageViews[i]
+					};
+
+					VkFramebufferCreateInfo frameBufferInfo = {};
+					frameBufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+					frameBufferInfo.renderPass = renderPass;
+					frameBufferInfo.attachmentCount = 1;
+					frameBufferInfo.pAttachments = attachments;
+					frameBufferInfo.width = swapChainExtent.width;
+					frameBufferInfo.height = swapChainExtent.height;
+					frameBufferInfo.layers = 1;
+
+					if (vkCreateFramebuffer(lDevice, &frameBufferInfo, nullptr, &swapChainFramebuffers[i]) != VK_SUCCESS) {
+						throw std::runtime_error("failed to create framebuffer!");
+					}
+				}
+			}
+
+			void createCommandPool(){
+				VkCommandPoolCreateInfo poolInfo = {};
+				poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+				poolInfo.queueFamilyIndex = workFamily();
+				poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT; // Recorded again each frame when there are inputs
+
+				if (vkCreateCommandPool(lDevice, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create command pool!");
+				}
+			}
+
+
+			// Two timestamps per command buffer, bracketing its draw.
+			void createQueryPool(){
+
+				uint32_t queueFamilyCount = 0;
+				vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+				std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+				vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+				uint32_t validBits = queueFamilies[workFamily()].timestampValidBits;
+				if(validBits == 0){
+					throw std::runtime_error("queue does not support timestamps!");
+				}
+				timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+				VkPhysicalDeviceProperties deviceProperties;
+				vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+				timestampPeriod = deviceProperties.limits.timestampPeriod;
+
+				VkQueryPoolCreateInfo queryPoolInfo = {};
+				queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+				queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+				queryPoolInfo.queryCount = 2 * static_cast<uint32_t>(frameSlotCount());
+
+				if (vkCreateQueryPool(lDevice, &queryPoolInfo, nullptr, &timestampPool) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create timestamp query pool!");
+				}
+
+				// And one statistics query each, if the device can count.
+				VkPhysicalDeviceFeatures deviceFeatures;
+				vkGetPhysicalDeviceFeatures(physicalDevice, &deviceFeatures);
+				if(deviceFeatures.pipelineStatisticsQuery){
+					VkQueryPoolCreateInfo statisticsPoolInfo = {};
+					statisticsPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+					statisticsPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+					statisticsPoolInfo.queryCount = static_cast<uint32_t>(frameSlotCount());
+					if(config.compute){
+						statisticsPoolInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+					} else {
+						statisticsPoolInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+							VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+							VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+							VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+					}
+
+					if (vkCreateQueryPool(lDevice, &statisticsPoolInfo, nullptr, &statisticsPool) != VK_SUCCESS) {
+						throw std::runtime_error("failed to create pipeline statistics query pool!");
+					}
+				} else {
+					std::cout << "device can't count shader invocations, no pipeline statistics" << std::endl;
+				}
+
+				pendingFrames.resize(frameSlotCount());
+			}
+
+			void createCommandBuffers() {
 				//Create command buffers
-				commandBuffers.resize(swapChainFramebuffers.size());
+				commandBuffers.resize(frameSlotCount());
 
 				VkCommandBufferAllocateInfo allocInfo = {};
 				allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -827,183 +2596,2256 @@ const std::vector<const char*> deviceExtensions = {
 				allocInfo.commandBufferCount = (uint32_t) commandBuffers.size();
 
 
-				if (vkAllocateCommandBuffers(lDevice, &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
-					throw std::runtime_error("failed to allocate command buffers!");
+				if (vkAllocateCommandBuffers(lDevice, &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
+					throw std::runtime_error("failed to allocate command buffers!");
+				}
+
+				//Begin recording the buffers
+				
+				for (size_t i = 0; i < commandBuffers.size(); i++) {
+					recordCommandBuffer(i);
+				}
+			}
+
+			// Also used to record a buffer again with new frame inputs, once the
+			// image it draws to is free.
+			void recordCommandBuffer(size_t i){
+				VkCommandBufferBeginInfo beginInfo = {};
+				beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+				beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT; //Allows beginning rendering the next frame.
+				
+				if (vkBeginCommandBuffer(commandBuffers[i], &beginInfo) != VK_SUCCESS) {
+					throw std::runtime_error("failed to begin recording command buffer!");
+				}
+				
+				if(config.compute){
+					recordDispatch(i);
+				} else {
+					recordDraw(i);
+				}
+
+				if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS) {
+					throw std::runtime_error("failed to record command buffer!");
+				}
+			}
+
+			// The draw, bracketed by its timestamps and statistics query.
+			void recordDraw(size_t i){
+				VkRenderPassBeginInfo renderPassInfo = {};
+				renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+				renderPassInfo.renderPass = renderPass;
+				renderPassInfo.framebuffer = swapChainFramebuffers[i];
+
+				renderPassInfo.renderArea.offset = {0, 0};
+				renderPassInfo.renderArea.extent = swapChainExtent;
+
+				VkClearValue clearColor = {0.0f, 0.0f, 0.0f, 1.0f}; //When clearing values use black.
+				renderPassInfo.clearValueCount = 1;
+				renderPassInfo.pClearValues = &clearColor;
+
+				// Timestamps can only be reset outside a render pass.
+				vkCmdResetQueryPool(commandBuffers[i], timestampPool, 2 * i, 2);
+				if(statisticsPool != VK_NULL_HANDLE){
+					vkCmdResetQueryPool(commandBuffers[i], statisticsPool, i, 1);
+				}
+
+				// Add render pass to command buffer
+				vkCmdBeginRenderPass(commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+				// Bind render pass to the pipeline
+				vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+				if(config.inputs){
+					vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1,
+							&inputsDescriptorSets[currentFrame], 0, nullptr);
+					vkCmdPushConstants(commandBuffers[i], pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+							0, sizeof(FrameInputs), &frameInputs);
+				}
+				if(resourceDescriptorSet != VK_NULL_HANDLE){
+					vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 1, 1,
+							&resourceDescriptorSet, 0, nullptr);
+				}
+				// Cover the whole image, whatever size it is now.
+				VkViewport viewport = {0.0f, 0.0f, (float) swapChainExtent.width, (float) swapChainExtent.height, 0.0f, 1.0f};
+				VkRect2D scissor = {{0, 0}, swapChainExtent};
+				vkCmdSetViewport(commandBuffers[i], 0, 1, &viewport);
+				vkCmdSetScissor(commandBuffers[i], 0, 1, &scissor);
+				// Draw things, timing only the draw itself.
+				vkCmdWriteTimestamp(commandBuffers[i], VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool, 2 * i);
+				if(statisticsPool != VK_NULL_HANDLE){
+					vkCmdBeginQuery(commandBuffers[i], statisticsPool, i, 0);
+				}
+				// Each pass covers the whole image, instances tell themselves
+				// apart by gl_InstanceIndex.
+				if(config.instanced){
+					vkCmdDraw(commandBuffers[i], 6, config.passes, 0, 0);
+				} else {
+					for(uint32_t pass = 0; pass < config.passes; pass++){
+						vkCmdDraw(commandBuffers[i], 6, 1, 0, 0);
+					}
+				}
+				if(statisticsPool != VK_NULL_HANDLE){
+					vkCmdEndQuery(commandBuffers[i], statisticsPool, i);
+				}
+				vkCmdWriteTimestamp(commandBuffers[i], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, 2 * i + 1);
+				// Finish the rendering.
+				vkCmdEndRenderPass(commandBuffers[i]);
+			}
+
+			// The compute version: each pass is one dispatch.
+			void recordDispatch(size_t i){
+				vkCmdResetQueryPool(commandBuffers[i], timestampPool, 2 * i, 2);
+				if(statisticsPool != VK_NULL_HANDLE){
+					vkCmdResetQueryPool(commandBuffers[i], statisticsPool, i, 1);
+				}
+
+				vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+				if(computeDescriptorSet != VK_NULL_HANDLE){
+					vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &computeDescriptorSet, 0, nullptr);
+				}
+				if(config.inputs){
+					vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 1, 1,
+							&inputsDescriptorSets[currentFrame], 0, nullptr);
+					vkCmdPushConstants(commandBuffers[i], pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(FrameInputs), &frameInputs);
+				}
+
+				vkCmdWriteTimestamp(commandBuffers[i], VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool, 2 * i);
+				if(statisticsPool != VK_NULL_HANDLE){
+					vkCmdBeginQuery(commandBuffers[i], statisticsPool, i, 0);
+				}
+				for(uint32_t pass = 0; pass < config.passes; pass++){
+					vkCmdDispatch(commandBuffers[i], config.dispatch[0], config.dispatch[1], config.dispatch[2]);
+				}
+				if(statisticsPool != VK_NULL_HANDLE){
+					vkCmdEndQuery(commandBuffers[i], statisticsPool, i);
+				}
+				vkCmdWriteTimestamp(commandBuffers[i], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, 2 * i + 1);
+			}
+
+			void createSyncObjects(){
+				imageAvailableSemaphores.resize(config.framesInFlight);
+				renderFinishedSemaphores.resize(config.framesInFlight);
+				inFlightFences.resize(config.framesInFlight);
+				imagesInFlight.resize(frameSlotCount(), VK_NULL_HANDLE);
+
+				VkSemaphoreCreateInfo semaphoreInfo = {};
+				semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+				// Signalled, so the first wait on each frame returns straight away.
+				VkFenceCreateInfo fenceInfo = {};
+				fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+				fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+				for (size_t i = 0; i < config.framesInFlight; i++) {
+					if (vkCreateSemaphore(lDevice, &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
+						vkCreateSemaphore(lDevice, &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS ||
+						vkCreateFence(lDevice, &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS){
+						throw std::runtime_error("failed to create synchronisation objects!");
+					}
+				}
+			}
+
+		void initVulkan(){
+			createInstance();
+			setupDebugCallback();
+			if(!config.headless){
+				createSurface();
+			}
+
+			selectPhysicalDevice();
+			createLogicalDevice();
+			createPipelineCache();
+			if(config.inputs){
+				createInputBuffers();
+			}
+
+			// Compute needs no images to draw to, only its own resources.
+			if(config.compute){
+				createCommandPool();
+				createComputeResources();
+				createQueryPool();
+				createSyncObjects();
+				return;
+			}
+			
+			if(config.headless){
+				createOffscreenImages({config.width, config.height});
+			} else {
+				createSwapChain();
+			}
+			createImageViews();
+			
+			createRenderPass();
+			
+			createFrameBuffers();
+			createCommandPool();
+			if(!config.resources.empty()){
+				createResources();
+			}
+			if(config.verify){
+				createVerifier();
+			}
+			createQueryPool();
+
+			createSyncObjects();
+		}
+
+		// Everything that depends on the shader being measured.
+		void loadShader(const std::string& shader){
+			shaderCompiled = isGlsl(shader);
+			if(config.compute){
+				createComputePipeline(shader);
+			} else {
+				createGraphicsPipeline(shader);
+			}
+			createCommandBuffers();
+		}
+
+		void unloadShader(){
+			vkFreeCommandBuffers(lDevice, commandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+			for(VkPipeline pipeline : variantPipelines){
+				vkDestroyPipeline(lDevice, pipeline, nullptr);
+			}
+			vkDestroyPipelineLayout(lDevice, pipelineLayout, nullptr);
+		}
+
+		// New offscreen images, framebuffers and command buffers at another size.
+		// The pipeline stays, the viewport and scissor are set when recording.
+		void resizeOffscreenImages(VkExtent2D extent){
+			vkDeviceWaitIdle(lDevice);
+			vkFreeCommandBuffers(lDevice, commandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+			for(size_t i = 0; i < swapChainImages.size(); i++){
+				vkDestroyFramebuffer(lDevice, swapChainFramebuffers[i], nullptr);
+				vkDestroyImageView(lDevice, swapChainImageViews[i], nullptr);
+				vkDestroyImage(lDevice, swapChainImages[i], nullptr);
+				vkFreeMemory(lDevice, offscreenImageMemory[i], nullptr);
+			}
+
+			createOffscreenImages(extent);
+			createImageViews();
+			createFrameBuffers();
+			createCommandBuffers();
+		}
+
+		// Every shader's static features against its GPU time per pass, in
+		// aule.static.csv, and how well each feature alone predicts the time.
+		void writeStaticReport(){
+			const char* names[] = {"instructions", "alu", "transcendental", "texture", "derivative", "branch",
+				"memory", "loops", "max_loop_depth", "function_variables", "peak_live_scalars"};
+			auto features = [](const SpirvStats& stats){
+				return std::vector<double>{double(stats.instructions), double(stats.alu), double(stats.transcendental),
+					double(stats.texture), double(stats.derivative), double(stats.branch), double(stats.memory),
+					double(stats.loops), double(stats.maxLoopDepth), double(stats.functionVariables), double(stats.peakLiveScalars)};
+			};
+			size_t featureCount = sizeof(names) / sizeof(names[0]);
+
+			std::string filename = config.deviceLabel.empty() ? "aule.static.csv" : "aule.static@" + config.deviceLabel + ".csv";
+			std::ofstream csv(filename);
+			if(!csv.is_open()){
+				throw std::runtime_error("failed to open " + filename);
+			}
+			csv << "shader,gpu_time_per_pass_us";
+			for(const char* name : names){
+				csv << "," << name;
+			}
+			csv << "\n";
+
+			std::vector<double> times;
+			std::vector<std::vector<double>> columns(featureCount);
+			for(const StaticRow& row : staticRows){
+				if(!(row.gpuTimePerPass_us > 0.0)){
+					continue; // No samples made it past warmup
+				}
+				std::vector<double> values = features(row.stats);
+				csv << row.shader << "," << row.gpuTimePerPass_us;
+				for(size_t f = 0; f < featureCount; f++){
+					csv << "," << values[f];
+					columns[f].push_back(values[f]);
+				}
+				csv << "\n";
+				times.push_back(row.gpuTimePerPass_us);
+			}
+
+			// Correlation of each feature with the time, signed.
+			std::cout << "static features against GPU time per pass over " << times.size() << " shaders, in " << filename << ":" << std::endl;
+			for(size_t f = 0; f < featureCount; f++){
+				if(std::adjacent_find(columns[f].begin(), columns[f].end(), std::not_equal_to<double>()) == columns[f].end()){
+					continue; // The same everywhere, nothing to learn
+				}
+				LinearFit fit = fitLine(columns[f], times);
+				std::cout << "  " << names[f] << ": r = " << std::copysign(std::sqrt(fit.r2), fit.slope) << std::endl;
+			}
+		}
+
+		// Where in the frame the time goes. The image is split into a grid of
+		// tiles, each drawn as a render pass of its own once everything before it
+		// has finished, so its timestamps hold only its own fragments. The median
+		// time of each tile goes to <shader>.heatmap.csv, and a picture of the
+		// cost per pixel to <shader>.heatmap.ppm.
+		void renderHeatmap(const std::string& shader){
+			finishVerification();
+			vkDeviceWaitIdle(lDevice);
+			uint32_t columns = config.heatmap.width;
+			uint32_t rows = config.heatmap.height;
+			uint32_t tiles = columns * rows;
+			VkExtent2D extent = swapChainExtent;
+			if(columns > extent.width || rows > extent.height){
+				throw std::runtime_error("more heatmap tiles than pixels!");
+			}
+
+			VkQueryPoolCreateInfo queryPoolInfo = {};
+			queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			queryPoolInfo.queryCount = 2 * tiles;
+			VkQueryPool tilePool;
+			if (vkCreateQueryPool(lDevice, &queryPoolInfo, nullptr, &tilePool) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create heatmap query pool!");
+			}
+
+			VkCommandBufferAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = commandPool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandBufferCount = 1;
+			VkCommandBuffer commandBuffer;
+			if (vkAllocateCommandBuffers(lDevice, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+				throw std::runtime_error("failed to allocate heatmap command buffer!");
+			}
+
+			VkFenceCreateInfo fenceInfo = {};
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			VkFence fence;
+			vkCreateFence(lDevice, &fenceInfo, nullptr, &fence);
+
+			VkCommandBufferBeginInfo beginInfo = {};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			vkBeginCommandBuffer(commandBuffer, &beginInfo);
+			vkCmdResetQueryPool(commandBuffer, tilePool, 0, 2 * tiles);
+
+			VkClearValue clearColor = {0.0f, 0.0f, 0.0f, 1.0f};
+			VkRenderPassBeginInfo renderPassInfo = {};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			renderPassInfo.renderPass = renderPass;
+			renderPassInfo.framebuffer = swapChainFramebuffers[0];
+			renderPassInfo.clearValueCount = 1;
+			renderPassInfo.pClearValues = &clearColor;
+			VkViewport viewport = {0.0f, 0.0f, (float) extent.width, (float) extent.height, 0.0f, 1.0f};
+
+			for(uint32_t tile = 0; tile < tiles; tile++){
+				uint32_t x = tile % columns;
+				uint32_t y = tile / columns;
+				VkRect2D rect;
+				rect.offset = {int32_t(x * extent.width / columns), int32_t(y * extent.height / rows)};
+				rect.extent = {(x + 1) * extent.width / columns - rect.offset.x, (y + 1) * extent.height / rows - rect.offset.y};
+
+				// Drain the tile before, so this one starts on an idle GPU.
+				vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+						0, 0, nullptr, 0, nullptr, 0, nullptr);
+				vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, tilePool, 2 * tile);
+
+				// The whole image's viewport, so the shader sees the coordinates it
+				// always does, cut down to the tile by the render area and scissor.
+				renderPassInfo.renderArea = rect;
+				vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+				if(config.inputs){
+					vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1,
+							&inputsDescriptorSets[currentFrame], 0, nullptr);
+					vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+							0, sizeof(FrameInputs), &frameInputs);
+				}
+				if(resourceDescriptorSet != VK_NULL_HANDLE){
+					vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 1, 1,
+							&resourceDescriptorSet, 0, nullptr);
+				}
+				vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+				vkCmdSetScissor(commandBuffer, 0, 1, &rect);
+				if(config.instanced){
+					vkCmdDraw(commandBuffer, 6, config.passes, 0, 0);
+				} else {
+					for(uint32_t pass = 0; pass < config.passes; pass++){
+						vkCmdDraw(commandBuffer, 6, 1, 0, 0);
+					}
+				}
+				vkCmdEndRenderPass(commandBuffer);
+				vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, tilePool, 2 * tile + 1);
+			}
+			vkEndCommandBuffer(commandBuffer);
+
+			// One frame at a time, there is nothing to overlap with.
+			std::vector<std::vector<double>> tileTimes(tiles);
+			std::vector<uint64_t> timestamps(2 * tiles);
+			for(uint32_t frame = 0; frame < HEATMAP_FRAMES; frame++){
+				VkSubmitInfo submitInfo = {};
+				submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+				submitInfo.commandBufferCount = 1;
+				submitInfo.pCommandBuffers = &commandBuffer;
+				if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, fence) != VK_SUCCESS) {
+					throw std::runtime_error("failed to submit heatmap command buffer!");
+				}
+				vkWaitForFences(lDevice, 1, &fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+				vkResetFences(lDevice, 1, &fence);
+
+				vkGetQueryPoolResults(lDevice, tilePool, 0, 2 * tiles, timestamps.size() * sizeof(uint64_t), timestamps.data(),
+						sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+				for(uint32_t tile = 0; tile < tiles; tile++){
+					uint64_t ticks = (timestamps[2 * tile + 1] - timestamps[2 * tile]) & timestampMask;
+					tileTimes[tile].push_back(ticks * timestampPeriod / 1000.0);
+				}
+			}
+
+			vkDestroyFence(lDevice, fence, nullptr);
+			vkFreeCommandBuffers(lDevice, commandPool, 1, &commandBuffer);
+			vkDestroyQueryPool(lDevice, tilePool, nullptr);
+
+			// Median of each tile, and its cost per pixel for the picture.
+			std::vector<double> medians(tiles);
+			std::vector<double> perPixel(tiles);
+			for(uint32_t tile = 0; tile < tiles; tile++){
+				std::vector<double>& times = tileTimes[tile];
+				std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+				medians[tile] = times[times.size() / 2];
+				double width = (tile % columns + 1) * extent.width / columns - (tile % columns) * extent.width / columns;
+				double height = (tile / columns + 1) * extent.height / rows - (tile / columns) * extent.height / rows;
+				perPixel[tile] = medians[tile] / (width * height);
+			}
+
+			std::ofstream csv(shader + ".heatmap.csv");
+			for(uint32_t y = 0; y < rows; y++){
+				for(uint32_t x = 0; x < columns; x++){
+					csv << (x > 0 ? "," : "") << medians[y * columns + x];
+				}
+				csv << "\n";
+			}
+
+			// Each pixel's tile, with the same boundaries the tiles were drawn with.
+			std::vector<uint32_t> pixelColumn(extent.width);
+			std::vector<uint32_t> pixelRow(extent.height);
+			for(uint32_t x = 0; x < columns; x++){
+				std::fill(pixelColumn.begin() + x * extent.width / columns, pixelColumn.begin() + (x + 1) * extent.width / columns, x);
+			}
+			for(uint32_t y = 0; y < rows; y++){
+				std::fill(pixelRow.begin() + y * extent.height / rows, pixelRow.begin() + (y + 1) * extent.height / rows, y);
+			}
+
+			// Black through red and yellow to white, hottest white.
+			double hottest = *std::max_element(perPixel.begin(), perPixel.end());
+			std::vector<uint8_t> pixels(size_t(extent.width) * extent.height * 4);
+			for(uint32_t py = 0; py < extent.height; py++){
+				for(uint32_t px = 0; px < extent.width; px++){
+					uint32_t tile = pixelRow[py] * columns + pixelColumn[px];
+					double heat = hottest > 0.0 ? perPixel[tile] / hottest : 0.0;
+					uint8_t* pixel = &pixels[(size_t(py) * extent.width + px) * 4];
+					pixel[0] = uint8_t(255.0 * std::clamp(3.0 * heat, 0.0, 1.0));
+					pixel[1] = uint8_t(255.0 * std::clamp(3.0 * heat - 1.0, 0.0, 1.0));
+					pixel[2] = uint8_t(255.0 * std::clamp(3.0 * heat - 2.0, 0.0, 1.0));
+					pixel[3] = 255;
+				}
+			}
+			writePpm(shader + ".heatmap.ppm", pixels.data(), extent.width, extent.height);
+
+			auto coolest = std::min_element(medians.begin(), medians.end());
+			auto hottestTile = std::max_element(medians.begin(), medians.end());
+			size_t hot = hottestTile - medians.begin();
+			std::cout << "  heatmap: " << columns << "x" << rows << " tiles from " << *coolest << " to " << *hottestTile
+				<< " us, hottest at column " << hot % columns << ", row " << hot / columns << std::endl;
+		}
+
+		// Benchmark each variant in turn on the same device, then tabulate their
+		// median GPU times against the fastest.
+		void benchmarkVariants(const std::string& shader){
+			std::vector<Summary> gpuTimes;
+			for(size_t v = 0; v < variants.size(); v++){
+				vkDeviceWaitIdle(lDevice);
+				vkFreeCommandBuffers(lDevice, commandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+				graphicsPipeline = computePipeline = variantPipelines[v];
+				createCommandBuffers();
+
+				mainLoop(shader + "." + variants[v].name);
+				gpuTimes.push_back(scaleSummary(gpuTimeStats.summarize(), 1.0 / config.passes));
+			}
+
+			double fastest = std::numeric_limits<double>::max();
+			for(const Summary& gpuTime : gpuTimes){
+				if(gpuTime.count > 0){
+					fastest = std::min(fastest, gpuTime.median);
+				}
+			}
+
+			std::ofstream csv(shader + ".variants.csv");
+			csv << "variant,median_gpu_time_us,median_ci_low_us,median_ci_high_us,relative\n";
+			std::cout << shader << ": median GPU time per pass, in microseconds" << std::endl;
+			for(size_t v = 0; v < variants.size(); v++){
+				const Summary& gpuTime = gpuTimes[v];
+				std::cout << "  " << variants[v].name << ": " << gpuTime.median
+					<< " [" << gpuTime.medianLow << ", " << gpuTime.medianHigh << "] x"
+					<< gpuTime.median / fastest << std::endl;
+				csv << variants[v].name << "," << gpuTime.median << "," << gpuTime.medianLow << ","
+					<< gpuTime.medianHigh << "," << gpuTime.median / fastest << "\n";
+			}
+		}
+
+		// Render the shader at each size of the sweep, then split its GPU time
+		// into a fixed cost and a cost per pixel. Below the crossover the fixed
+		// cost dominates, above it the shader is fill rate bound.
+		void sweepSizes(const std::string& shader){
+			std::vector<double> pixels;
+			std::vector<double> gpuTimes;
+
+			std::ofstream csv(shader + ".sweep.csv");
+			csv << "width,height,pixels,median_gpu_time_us,median_frame_time_us\n";
+			for(VkExtent2D extent : config.sweep){
+				resizeOffscreenImages(extent);
+				std::string size = std::to_string(extent.width) + "x" + std::to_string(extent.height);
+				mainLoop(shader + "." + size);
+
+				if(gpuTimeStats.size() == 0){
+					continue;
+				}
+				pixels.push_back(double(extent.width) * extent.height);
+				gpuTimes.push_back(gpuTimeStats.distribution().quantile(0.5));
+				csv << extent.width << "," << extent.height << "," << pixels.back() << "," << gpuTimes.back()
+					<< "," << frameTimeStats.distribution().quantile(0.5) << "\n";
+			}
+
+			// Sizes with the same pixel count give the fit nothing to go on
+			std::vector<double> distinct = pixels;
+			std::sort(distinct.begin(), distinct.end());
+			if(std::unique(distinct.begin(), distinct.end()) - distinct.begin() < 2){
+				std::cout << shader << ": too few distinct pixel counts measured to fit" << std::endl;
+				return;
+			}
+
+			// Only a positive fixed cost and cost per pixel cross over
+			LinearFit fit = fitLine(pixels, gpuTimes);
+			double crossover = fit.slope > 0.0 && fit.intercept > 0.0 ? fit.intercept / fit.slope : std::numeric_limits<double>::quiet_NaN();
+			std::cout << shader << ": GPU time = " << fit.intercept << " us + " << fit.slope * 1000.0
+				<< " ns/pixel (r^2 " << fit.r2 << "), ";
+			if(std::isfinite(crossover)){
+				std::cout << "fixed cost dominates below " << crossover << " pixels" << std::endl;
+			} else {
+				std::cout << "no crossover" << std::endl;
+			}
+
+			std::ofstream json(shader + ".sweep.json");
+			json << "{\"shader\": " << jsonString(shader)
+				<< ", \"fixed_us\": " << fit.intercept
+				<< ", \"ns_per_pixel\": " << fit.slope * 1000.0
+				<< ", \"r2\": " << fit.r2
+				<< ", \"crossover_pixels\": " << jsonNumber(crossover) << "}\n";
+		}
+
+			// Make sure nothing still in flight is using this image, then claim it
+			// for the current frame. Its last GPU time is ready once it is free.
+			void claimImage(uint32_t imageIndex){
+				if (imagesInFlight[imageIndex] != VK_NULL_HANDLE) {
+					vkWaitForFences(lDevice, 1, &imagesInFlight[imageIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+				}
+				imagesInFlight[imageIndex] = inFlightFences[currentFrame];
+				collectGpuTime(imageIndex, true);
+			}
+
+			// This frame's inputs, into its uniform buffer and the image's command
+			// buffer. The frame's fence has been waited on, so neither is in use.
+			void updateInputs(uint32_t imageIndex){
+				frameInputs.time = std::chrono::duration<float>(std::chrono::steady_clock::now() - inputsStart).count();
+				frameInputs.frame++;
+				if(config.compute){
+					frameInputs.resolution[0] = float(config.dispatch[0]);
+					frameInputs.resolution[1] = float(config.dispatch[1]);
+				} else {
+					frameInputs.resolution[0] = float(swapChainExtent.width);
+					frameInputs.resolution[1] = float(swapChainExtent.height);
+				}
+				frameInputs.seed = config.seed;
+
+				memcpy(inputsMapped[currentFrame], &frameInputs, sizeof(frameInputs));
+				recordCommandBuffer(imageIndex);
+			}
+
+			// Render without a swapchain: nothing to wait on and nothing to present.
+			uint32_t drawOffscreenFrame(){
+				vkWaitForFences(lDevice, 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+				uint32_t imageIndex = nextOffscreenImage;
+				nextOffscreenImage = (nextOffscreenImage + 1) % frameSlotCount();
+				claimImage(imageIndex);
+				if(config.inputs){
+					updateInputs(imageIndex);
+				} else if(!arms.empty()){
+					recordCommandBuffer(imageIndex); // With this block's shader
+				}
+
+				VkSubmitInfo submitInfo = {};
+				submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+				submitInfo.commandBufferCount = 1;
+				submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
+
+				VkQueue queue = config.compute ? computeQueue : graphicsQueue;
+				vkResetFences(lDevice, 1, &inFlightFences[currentFrame]);
+				if (vkQueueSubmit(queue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
+					    throw std::runtime_error("failed to submit draw command buffer!");
+				}
+
+				if(config.latencyMode){
+					vkQueueWaitIdle(queue);
+				}
+				currentFrame = (currentFrame + 1) % config.framesInFlight;
+				return imageIndex;
+			}
+
+			uint32_t drawFrame(){
+				// Don't get more than framesInFlight ahead of the GPU
+				vkWaitForFences(lDevice, 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+				uint32_t imageIndex;
+				//Take an image from the swapchain, once available
+				vkAcquireNextImageKHR(lDevice, swapChain, std::numeric_limits<uint64_t>::max(),
+						imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+				claimImage(imageIndex);
+				if(config.inputs){
+					updateInputs(imageIndex);
+				} else if(!arms.empty()){
+					recordCommandBuffer(imageIndex); // With this block's shader
+				}
+
+				//Render an image, once needed
+				VkSubmitInfo submitInfo = {};
+				submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+				VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
+				VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+				submitInfo.waitSemaphoreCount = 1;
+				submitInfo.pWaitSemaphores = waitSemaphores;
+				submitInfo.pWaitDstStageMask = waitStages;
+
+				submitInfo.commandBufferCount = 1;
+				submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
+				
+				VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
+				submitInfo.signalSemaphoreCount = 1;
+				submitInfo.pSignalSemaphores = signalSemaphores;
+				
+				vkResetFences(lDevice, 1, &inFlightFences[currentFrame]);
+				if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
+					    throw std::runtime_error("failed to submit draw command buffer!");
+				}
+				
+				//Put an image onto the swapchain
+				
+				VkPresentInfoKHR presentInfo = {};
+				presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+				
+				presentInfo.waitSemaphoreCount = 1;
+				presentInfo.pWaitSemaphores = signalSemaphores;
+				
+				VkSwapchainKHR swapChains[] = {swapChain};
+				presentInfo.swapchainCount = 1;
+				presentInfo.pSwapchains = swapChains;
+				presentInfo.pImageIndices = &imageIndex;
+				
+			    vkQueuePresentKHR(presentQueue, &presentInfo);
+				// Latency mode runs one frame at a time, the GPU idles between them.
+				if(config.latencyMode){
+					vkQueueWaitIdle(presentQueue);
+				}
+				currentFrame = (currentFrame + 1) % config.framesInFlight;
+				return imageIndex;
+			}
+
+		// Write out the GPU time of the frame last drawn to an image, once its
+		// timestamps have landed, alongside its CPU frame time. Only blocks when
+		// asked to wait.
+		void collectGpuTime(size_t i, bool wait){
+			if(!pendingFrames[i].pending){
+				return;
+			}
+
+			// Each timestamp is followed by its availability.
+			uint64_t results[4] = {};
+			VkQueryResultFlags flags = VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT;
+			if(wait){
+				flags |= VK_QUERY_RESULT_WAIT_BIT;
+			}
+			vkGetQueryPoolResults(lDevice, timestampPool, 2 * i, 2, sizeof(results), results,
+					2 * sizeof(uint64_t), flags);
+			if(results[1] == 0 || results[3] == 0){
+				return;
+			}
+
+			// Interleaved, the frame counts for the shader it was drawn with.
+			Arm* arm = arms.empty() ? nullptr : &arms[pendingFrames[i].arm];
+			PipelineCounts& totals = arm ? arm->pipelineTotals : pipelineTotals;
+			FrameRecorder& frameRecorder = arm ? arm->recorder : recorder;
+			SampleStats& frameStats = arm ? arm->frameTimeStats : frameTimeStats;
+			SampleStats& gpuStats = arm ? arm->gpuTimeStats : gpuTimeStats;
+
+			// The counters (four, or one for compute), then availability.
+			uint64_t counts[5] = {};
+			if(statisticsPool != VK_NULL_HANDLE){
+				size_t counters = config.compute ? 1 : 4;
+				vkGetQueryPoolResults(lDevice, statisticsPool, i, 1, sizeof(counts), counts, (counters + 1) * sizeof(uint64_t), flags);
+				if(counts[counters] == 0){
+					return;
+				}
+				if(config.compute){
+					totals.computeInvocations += counts[0];
+				} else {
+					totals.vertexInvocations += counts[0];
+					totals.clippingInvocations += counts[1];
+					totals.clippingPrimitives += counts[2];
+					totals.fragmentInvocations += counts[3];
+				}
+				(arm ? arm->pipelineFrames : pipelineFrames)++;
+			}
+
+			float gpuTime_us = float((results[2] - results[0]) & timestampMask) * timestampPeriod / 1000.0f;
+			if(config.keepSamples){
+				frameRecorder.record(pendingFrames[i].frameTime_us, gpuTime_us);
+			}
+			pendingFrames[i].pending = false;
+
+			// The ramp counts like any other frame until the clocks are seen to
+			// settle, then the statistics start again from there; a run that never
+			// settles is summarised whole. Interleaved shaders each watch their own
+			// frames, and have settled once all of them have.
+			if(config.steadyState && !calibrating && !settled()){
+				rampFrames++;
+				(arm ? arm->rampDetector : rampDetector).add(gpuTime_us);
+				if(settled()){
+					frameTimeStats.reset(0);
+					gpuTimeStats.reset(0);
+					for(Arm& each : arms){
+						each.frameTimeStats.reset(0);
+						each.gpuTimeStats.reset(0);
+					}
+					return;
+				}
+			}
+			frameStats.add(pendingFrames[i].frameTime_us);
+			gpuStats.add(gpuTime_us);
+		}
+
+		// Past the clock ramp, on every shader when interleaving.
+		bool settled(){
+			if(arms.empty()){
+				return rampDetector.isSteady();
+			}
+			return std::all_of(arms.begin(), arms.end(), [](const Arm& arm){ return arm.rampDetector.isSteady(); });
+		}
+
+		void collectGpuTimes(bool wait){
+			for(size_t i = 0; i < pendingFrames.size(); i++){
+				collectGpuTime(i, wait);
+			}
+		}
+
+		// Everything needed to make sense of a results file later.
+		ResultsHeader makeResultsHeader(const std::string& shader){
+			VkPhysicalDeviceProperties deviceProperties;
+			vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+
+			ResultsHeader header = {};
+			strncpy(header.deviceName, deviceProperties.deviceName, sizeof(header.deviceName) - 1);
+			strncpy(header.shaderName, shader.c_str(), sizeof(header.shaderName) - 1);
+			header.vendorID = deviceProperties.vendorID;
+			header.deviceID = deviceProperties.deviceID;
+			header.driverVersion = deviceProperties.driverVersion;
+			header.width = swapChainExtent.width;
+			header.height = swapChainExtent.height;
+			header.presentMode = swapChainPresentMode;
+			header.profile = config.debug ? PROFILE_DEBUG : PROFILE_MEASURE;
+			header.framesInFlight = config.framesInFlight;
+			header.spirvHash = shaderHash;
+			header.passes = config.passes;
+			return header;
+		}
+
+		// Print the summary statistics, and keep them in <shader>.summary.json.
+		void writeSummary(const std::string& shader){
+			Summary frameTime = frameTimeStats.summarize();
+			Summary gpuTime = gpuTimeStats.summarize();
+
+			std::cout << "  times in microseconds, median with its 95% confidence interval" << std::endl;
+			printSummary(std::cout, "frame time", frameTime);
+			printSummary(std::cout, "GPU time", gpuTime);
+			if(config.passes > 1){
+				printSummary(std::cout, "GPU time per pass", scaleSummary(gpuTime, 1.0 / config.passes));
+			}
+
+			// Work per frame, and how fast the median frame got through it. More than
+			// one fragment per pixel is overshading, mostly the helper invocations
+			// along the diagonal the quad's two triangles share.
+			double pixels = double(swapChainExtent.width) * swapChainExtent.height;
+			double frames = std::max<uint64_t>(pipelineFrames, 1);
+			// Rates need a GPU time and some work to divide it by, otherwise they
+			// are left out, and null in the JSON.
+			double fragments = pipelineTotals.fragmentInvocations / frames;
+			double invocations = pipelineTotals.computeInvocations / frames;
+			double nan = std::numeric_limits<double>::quiet_NaN();
+			bool timed = gpuTime.count > 0 && gpuTime.median > 0.0;
+			double nsPerFragment = timed && fragments > 0.0 ? gpuTime.median * 1000.0 / fragments : nan;
+			double nsPerInvocation = timed && invocations > 0.0 ? gpuTime.median * 1000.0 / invocations : nan;
+			if(pipelineFrames > 0 && config.compute){
+				std::cout << "  per frame: " << invocations << " invocations" << std::endl;
+				if(std::isfinite(nsPerInvocation)){
+					std::cout << "  " << nsPerInvocation << " ns/invocation, " << 1.0 / nsPerInvocation << " Ginvocations/s" << std::endl;
+				}
+			} else if(pipelineFrames > 0){
+				std::cout << "  per frame: " << pipelineTotals.vertexInvocations / frames << " vertex invocations, "
+					<< pipelineTotals.clippingInvocations / frames << " primitives clipped to "
+					<< pipelineTotals.clippingPrimitives / frames << ", "
+					<< fragments << " fragment invocations (" << fragments / pixels / config.passes << " per pixel per pass)" << std::endl;
+				if(std::isfinite(nsPerFragment)){
+					std::cout << "  " << nsPerFragment << " ns/fragment, " << 1.0 / nsPerFragment << " Gfragments/s" << std::endl;
+				}
+			}
+			std::cout << "  static: " << shaderStats.instructions << " instructions, " << shaderStats.alu << " ALU, "
+				<< shaderStats.transcendental << " transcendental, " << shaderStats.texture << " texture, "
+				<< shaderStats.derivative << " derivative, " << shaderStats.branch << " branch, "
+				<< shaderStats.loops << " loops nested " << shaderStats.maxLoopDepth << " deep, ~"
+				<< shaderStats.peakLiveScalars << " live scalars" << std::endl;
+			staticRows.push_back({shader, shaderStats, gpuTime.median / config.passes});
+
+			std::vector<PipelineExecutable> executables = queryPipelineExecutables(config.compute ? computePipeline : graphicsPipeline, shader);
+			for(const PipelineExecutable& executable : executables){
+				std::cout << "  " << executable.name << ":";
+				for(size_t i = 0; i < executable.statistics.size(); i++){
+					std::cout << (i > 0 ? ", " : " ") << executable.statistics[i].first << " " << executable.statistics[i].second;
+				}
+				std::cout << std::endl;
+			}
+
+			VkPhysicalDeviceProperties deviceProperties;
+			vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+
+			std::ofstream json(shader + ".summary.json");
+			json << "{\n";
+			json << "  \"shader\": " << jsonString(shader) << ",\n";
+			json << "  \"device\": " << jsonString(deviceProperties.deviceName) << ",\n";
+			json << "  \"profile\": " << jsonString(config.debug ? "debug" : "measure") << ",\n";
+			json << "  \"warmup_frames\": " << config.warmupFrames << ",\n";
+			if(config.steadyState){
+				json << "  \"ramp_frames\": " << rampFrames << ",\n";
+			}
+			json << "  \"stop_reason\": " << jsonString(stopReason) << ",\n";
+			json << "  \"frame_time_us\": ";
+			writeSummaryJson(json, frameTime);
+			json << ",\n  \"gpu_time_us\": ";
+			writeSummaryJson(json, gpuTime);
+			json << ",\n  \"passes\": " << config.passes;
+			json << ",\n  \"gpu_time_per_pass_us\": ";
+			writeSummaryJson(json, scaleSummary(gpuTime, 1.0 / config.passes));
+			if(!config.resources.empty()){
+				json << ",\n  \"resources\": [";
+				for(size_t i = 0; i < config.resources.size(); i++){
+					json << (i > 0 ? ", " : "") << jsonString(config.resources[i].spec);
+				}
+				json << "]";
+			}
+			json << ",\n  \"spirv\": ";
+			writeSpirvStatsJson(json, shaderStats);
+			if(hasExecutableProperties){
+				json << ",\n  \"pipeline_executables\": [";
+				for(size_t e = 0; e < executables.size(); e++){
+					const PipelineExecutable& executable = executables[e];
+					json << (e > 0 ? ", " : "") << "{\"name\": " << jsonString(executable.name)
+						<< ", \"description\": " << jsonString(executable.description)
+						<< ", \"stages\": " << executable.stages
+						<< ", \"subgroup_size\": " << executable.subgroupSize << ", \"statistics\": {";
+					for(size_t i = 0; i < executable.statistics.size(); i++){
+						json << (i > 0 ? ", " : "") << jsonString(executable.statistics[i].first) << ": " << executable.statistics[i].second;
+					}
+					json << "}}";
+				}
+				json << "]";
+			}
+			if(shaderCompiled){
+				json << ",\n  \"compile\": {\"optimization\": " << jsonString(config.compile.optimization) << ", \"defines\": [";
+				for(size_t i = 0; i < config.compile.defines.size(); i++){
+					json << (i > 0 ? ", " : "") << jsonString(config.compile.defines[i]);
+				}
+				json << "]}";
+			}
+			if(config.compute){
+				json << ",\n  \"dispatch\": [" << config.dispatch[0] << ", " << config.dispatch[1] << ", " << config.dispatch[2] << "]";
+			}
+			if(pipelineFrames > 0 && config.compute){
+				json << ",\n  \"pipeline_statistics\": {\"compute_invocations\": " << invocations
+					<< ", \"ns_per_invocation\": " << jsonNumber(nsPerInvocation)
+					<< ", \"ginvocations_per_s\": " << jsonNumber(1.0 / nsPerInvocation) << "}";
+			} else if(pipelineFrames > 0){
+				json << ",\n  \"pipeline_statistics\": {\"vertex_invocations\": " << pipelineTotals.vertexInvocations / frames
+					<< ", \"clipping_invocations\": " << pipelineTotals.clippingInvocations / frames
+					<< ", \"clipping_primitives\": " << pipelineTotals.clippingPrimitives / frames
+					<< ", \"fragment_invocations\": " << fragments
+					<< ", \"fragments_per_pixel\": " << fragments / pixels / config.passes
+					<< ", \"ns_per_fragment\": " << jsonNumber(nsPerFragment)
+					<< ", \"gfragments_per_s\": " << jsonNumber(1.0 / nsPerFragment) << "}";
+			}
+			json << "\n}\n";
+		}
+
+		// Whether the run has what it came for. Sets stopReason when it has.
+		bool shouldStop(uint32_t frame, float seconds){
+			if(config.frameCount != 0 && frame >= config.frameCount){
+				stopReason = "frames";
+			} else if(config.duration > 0.0 && seconds >= config.duration){
+				stopReason = "duration";
+			} else if(config.convergeTarget > 0.0 && frame % config.windowFrames == 0 && hasConverged()){
+				stopReason = "converged";
+			}
+			return !stopReason.empty();
+		}
+
+		// Called once a window; counts the windows in a row where the GPU time's
+		// median is pinned down to the target, every shader's when interleaving.
+		bool hasConverged(){
+			if(config.steadyState && !settled()){
+				return false;
+			}
+			auto pinned = [&](const SampleStats& stats){
+				return stats.size() >= config.windowFrames && stats.relativeMedianCi() <= config.convergeTarget;
+			};
+			bool converged = arms.empty() ? pinned(gpuTimeStats) :
+				std::all_of(arms.begin(), arms.end(), [&](const Arm& arm){ return pinned(arm.gpuTimeStats); });
+			if(converged){
+				convergedWindows++;
+			} else {
+				convergedWindows = 0;
+			}
+			return convergedWindows >= config.stableWindows;
+		}
+
+		// A buffer the CPU can see, mapped for as long as it lives.
+		void createHostBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& memory, void*& mapped){
+			VkBufferCreateInfo bufferInfo = {};
+			bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.size = size;
+			bufferInfo.usage = usage;
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			if (vkCreateBuffer(lDevice, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create buffer!");
+			}
+
+			VkMemoryRequirements memRequirements;
+			vkGetBufferMemoryRequirements(lDevice, buffer, &memRequirements);
+			VkMemoryAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocInfo.allocationSize = memRequirements.size;
+			allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			if (vkAllocateMemory(lDevice, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+				throw std::runtime_error("failed to allocate buffer memory!");
+			}
+			vkBindBufferMemory(lDevice, buffer, memory, 0);
+			vkMapMemory(lDevice, memory, 0, size, 0, &mapped);
+		}
+
+		// The verify.comp pipeline and everything that doesn't depend on the
+		// frame size. The staging and golden buffers come with the first frame.
+		void createVerifier(){
+			VkDescriptorSetLayoutBinding bindings[3] = {};
+			for(uint32_t i = 0; i < 3; i++){
+				bindings[i] = {i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr};
+			}
+			VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+			layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+			layoutInfo.bindingCount = 3;
+			layoutInfo.pBindings = bindings;
+			if (vkCreateDescriptorSetLayout(lDevice, &layoutInfo, nullptr, &verifySetLayout) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create descriptor set layout!");
+			}
+
+			VkDescriptorPoolSize poolSize = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3};
+			VkDescriptorPoolCreateInfo poolInfo = {};
+			poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+			poolInfo.maxSets = 1;
+			poolInfo.poolSizeCount = 1;
+			poolInfo.pPoolSizes = &poolSize;
+			if (vkCreateDescriptorPool(lDevice, &poolInfo, nullptr, &verifyDescriptorPool) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create descriptor pool!");
+			}
+
+			VkDescriptorSetAllocateInfo setInfo = {};
+			setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			setInfo.descriptorPool = verifyDescriptorPool;
+			setInfo.descriptorSetCount = 1;
+			setInfo.pSetLayouts = &verifySetLayout;
+			if (vkAllocateDescriptorSets(lDevice, &setInfo, &verifySet) != VK_SUCCESS) {
+				throw std::runtime_error("failed to allocate descriptor set!");
+			}
+
+			// Pixel count, tolerance, and whether there is a golden image
+			VkPushConstantRange pushConstantRange = {VK_SHADER_STAGE_COMPUTE_BIT, 0, 3 * sizeof(uint32_t)};
+			VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+			pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+			pipelineLayoutInfo.setLayoutCount = 1;
+			pipelineLayoutInfo.pSetLayouts = &verifySetLayout;
+			pipelineLayoutInfo.pushConstantRangeCount = 1;
+			pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+			if (vkCreatePipelineLayout(lDevice, &pipelineLayoutInfo, nullptr, &verifyPipelineLayout) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create pipeline layout!");
+			}
+
+			auto verifyShaderCode = readFile("./verify.spv");
+			VkShaderModule verifyShader = createShaderModule(verifyShaderCode);
+			VkComputePipelineCreateInfo pipelineInfo = {};
+			pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+			pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+			pipelineInfo.stage.module = verifyShader;
+			pipelineInfo.stage.pName = "main";
+			pipelineInfo.layout = verifyPipelineLayout;
+			if (vkCreateComputePipelines(lDevice, pipelineCache, 1, &pipelineInfo, nullptr, &verifyPipeline) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create verification pipeline!");
+			}
+			vkDestroyShaderModule(lDevice, verifyShader, nullptr);
+
+			createHostBuffer(sizeof(VerifyResult), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+					verifyResultBuffer, verifyResultMemory, verifyResultMapped);
+
+			VkCommandBufferAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = commandPool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandBufferCount = 1;
+			if (vkAllocateCommandBuffers(lDevice, &allocInfo, &verifyCommandBuffer) != VK_SUCCESS) {
+				throw std::runtime_error("failed to allocate command buffers!");
+			}
+
+			VkFenceCreateInfo fenceInfo = {};
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			if (vkCreateFence(lDevice, &fenceInfo, nullptr, &verifyFence) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create fence!");
+			}
+		}
+
+		void destroyVerifyBuffers(){
+			if(stagingBuffer == VK_NULL_HANDLE){
+				return;
+			}
+			vkDestroyBuffer(lDevice, stagingBuffer, nullptr);
+			vkFreeMemory(lDevice, stagingMemory, nullptr);
+			vkDestroyBuffer(lDevice, goldenBuffer, nullptr);
+			vkFreeMemory(lDevice, goldenMemory, nullptr);
+			stagingBuffer = VK_NULL_HANDLE;
+		}
+
+		// Copy the last frame out and set verify.comp going on it, without
+		// waiting. The device is idle, so the frame is finished.
+		void startVerification(const std::string& shader){
+			VkDeviceSize size = VkDeviceSize(swapChainExtent.width) * swapChainExtent.height * 4;
+			if(size != verifyBufferSize){
+				destroyVerifyBuffers();
+				createHostBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+						stagingBuffer, stagingMemory, stagingMapped);
+				createHostBuffer(size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, goldenBuffer, goldenMemory, goldenMapped);
+				verifyBufferSize = size;
+
+				VkDescriptorBufferInfo bufferInfos[3] = {
+					{stagingBuffer, 0, VK_WHOLE_SIZE}, {goldenBuffer, 0, VK_WHOLE_SIZE}, {verifyResultBuffer, 0, VK_WHOLE_SIZE}};
+				VkWriteDescriptorSet writes[3] = {};
+				for(uint32_t i = 0; i < 3; i++){
+					writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+					writes[i].dstSet = verifySet;
+					writes[i].dstBinding = i;
+					writes[i].descriptorCount = 1;
+					writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+					writes[i].pBufferInfo = &bufferInfos[i];
+				}
+				vkUpdateDescriptorSets(lDevice, 3, writes, 0, nullptr);
+			}
+			verifyExtent = swapChainExtent;
+			verifyLabel = shader;
+
+			// No golden image means a checksum only, as does writing a new one.
+			verifyCompare = false;
+			std::string golden = goldenPath(shader);
+			if(!config.writeGolden && std::filesystem::exists(golden)){
+				uint32_t width, height;
+				std::vector<uint8_t> pixels = readPpm(golden, width, height);
+				if(width != verifyExtent.width || height != verifyExtent.height){
+					throw std::runtime_error(golden + " is " + std::to_string(width) + "x" + std::to_string(height) +
+							", the frame is " + std::to_string(verifyExtent.width) + "x" + std::to_string(verifyExtent.height));
+				}
+				memcpy(goldenMapped, pixels.data(), pixels.size());
+				verifyCompare = true;
+			}
+			memset(verifyResultMapped, 0, sizeof(VerifyResult));
+
+			VkCommandBufferBeginInfo beginInfo = {};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			vkBeginCommandBuffer(verifyCommandBuffer, &beginInfo);
+
+			// The render pass left the image ready to copy from.
+			VkBufferImageCopy region = {};
+			region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+			region.imageExtent = {verifyExtent.width, verifyExtent.height, 1};
+			vkCmdCopyImageToBuffer(verifyCommandBuffer, swapChainImages[lastImageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+					stagingBuffer, 1, &region);
+
+			VkMemoryBarrier copied = {VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT};
+			vkCmdPipelineBarrier(verifyCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					0, 1, &copied, 0, nullptr, 0, nullptr);
+
+			uint32_t pixelCount = verifyExtent.width * verifyExtent.height;
+			uint32_t params[3] = {pixelCount, config.tolerance, verifyCompare};
+			vkCmdBindPipeline(verifyCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, verifyPipeline);
+			vkCmdBindDescriptorSets(verifyCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, verifyPipelineLayout, 0, 1, &verifySet, 0, nullptr);
+			vkCmdPushConstants(verifyCommandBuffer, verifyPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(params), params);
+			// Workgroups in rows, there can be more than fit along x.
+			uint32_t groups = (pixelCount + VERIFY_GROUP_SIZE - 1) / VERIFY_GROUP_SIZE;
+			uint32_t groupsX = std::min<uint32_t>(groups, 65535);
+			vkCmdDispatch(verifyCommandBuffer, groupsX, (groups + groupsX - 1) / groupsX, 1);
+
+			VkMemoryBarrier reduced = {VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT};
+			vkCmdPipelineBarrier(verifyCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+					0, 1, &reduced, 0, nullptr, 0, nullptr);
+			vkEndCommandBuffer(verifyCommandBuffer);
+
+			VkSubmitInfo submitInfo = {};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &verifyCommandBuffer;
+			if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, verifyFence) != VK_SUCCESS) {
+				throw std::runtime_error("failed to submit verification command buffer!");
+			}
+			verifyPending = true;
+		}
+
+		// Wait for the last verification, if any, and report it. Called before
+		// anything else is timed.
+		void finishVerification(){
+			if(!verifyPending){
+				return;
+			}
+			vkWaitForFences(lDevice, 1, &verifyFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+			vkResetFences(lDevice, 1, &verifyFence);
+			verifyPending = false;
+
+			VerifyResult result;
+			memcpy(&result, verifyResultMapped, sizeof(result));
+			char checksum[16];
+			snprintf(checksum, sizeof(checksum), "%08x", result.checksum);
+			std::cout << verifyLabel << ": checksum " << checksum;
+
+			if(config.writeGolden){
+				writePpm(goldenPath(verifyLabel), static_cast<const uint8_t*>(stagingMapped), verifyExtent.width, verifyExtent.height);
+				std::cout << ", written to " << goldenPath(verifyLabel) << std::endl;
+				return;
+			}
+			if(!verifyCompare){
+				std::cout << ", no golden image" << std::endl;
+				return;
+			}
+
+			double pixels = double(verifyExtent.width) * verifyExtent.height;
+			std::cout << ", error against golden image (max/mean) rgb";
+			for(int c = 0; c < 3; c++){
+				uint64_t sum = (uint64_t(result.sumErrorHigh[c]) << 32) | result.sumErrorLow[c];
+				std::cout << " " << result.maxError[c] << "/" << sum / pixels;
+			}
+			if(result.mismatched > 0){
+				std::cout << ", MISMATCH in " << result.mismatched << " pixels" << std::endl;
+				verifyFailures++;
+			} else {
+				std::cout << ", matches" << std::endl;
+			}
+		}
+
+		// Golden images are shared by all devices and optimization levels, so
+		// leave the labels out. Sweep sizes and variants, after them, stay.
+		std::string goldenPath(const std::string& shader){
+			std::string filename = std::filesystem::path(shader).filename().string();
+			for(const std::string& label : {"@O" + config.compile.optimization, "@" + config.deviceLabel}){
+				size_t at = filename.find(label);
+				if(label.size() > 1 && at != std::string::npos){
+					filename.erase(at, label.size());
+				}
+			}
+			return config.goldenDir + "/" + filename + ".ppm";
+		}
+
+		// What a shader's results are called, which says which device when there
+		// are several, and how GLSL was compiled when it wasn't the default.
+		std::string named(const std::string& shader){
+			std::string name = shader;
+			if(isGlsl(shader) && config.compile.optimization != "performance"){
+				name += "@O" + config.compile.optimization;
+			}
+			if(!config.deviceLabel.empty()){
+				name += "@" + config.deviceLabel;
+			}
+			return name;
+		}
+
+		// Draw a frame and time it from the end of the last one. False once the
+		// window has been closed.
+		bool renderFrame(std::chrono::steady_clock::time_point& time){
+			uint32_t imageIndex;
+			if(config.headless){
+				imageIndex = drawOffscreenFrame();
+			} else {
+				if(glfwWindowShouldClose(window)){
+					return false;
 				}
+				glfwPollEvents();
+				imageIndex = drawFrame();
+			}
+			auto now = std::chrono::steady_clock::now();
+			float frameTime_us = std::chrono::duration<float, std::micro>(now - time).count();
+			time = now;
+
+			lastImageIndex = imageIndex;
+
+			// The GPU time arrives later, once the timestamps are available.
+			pendingFrames[imageIndex].pending = true;
+			pendingFrames[imageIndex].frameTime_us = frameTime_us;
+			pendingFrames[imageIndex].arm = currentArm;
+			collectGpuTimes(false);
+			return true;
+		}
 
-				//Begin recording the buffers
-				
-				for (size_t i = 0; i < commandBuffers.size(); i++) {
-					VkCommandBufferBeginInfo beginInfo = {};
-					beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-					beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT; //Allows beginning rendering the next frame.
-					
-					if (vkBeginCommandBuffer(commandBuffers[i], &beginInfo) != VK_SUCCESS) {
-						throw std::runtime_error("failed to begin recording command buffer!");
+		// Double the passes per frame until the GPU, not submitting and
+		// presenting, sets the frame time, so cheap shaders are measured
+		// doing real work.
+		void calibratePasses(const std::string& shader){
+			finishVerification();
+			calibrating = true;
+			recorder.reset(0);
+			for(config.passes = 1; ; config.passes *= 2){
+				vkDeviceWaitIdle(lDevice);
+				vkFreeCommandBuffers(lDevice, commandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+				createCommandBuffers();
+
+				frameTimeStats.reset(CALIBRATION_FRAMES / 4);
+				gpuTimeStats.reset(CALIBRATION_FRAMES / 4);
+				auto time = std::chrono::steady_clock::now();
+				for(uint32_t frame = 0; frame < CALIBRATION_FRAMES; frame++){
+					if(!renderFrame(time)){
+						break;
 					}
-					
-					//Commands for the command buffer
-					VkRenderPassBeginInfo renderPassInfo = {};
-					renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-					renderPassInfo.renderPass = renderPass;
-					renderPassInfo.framebuffer = swapChainFramebuffers[i];
+				}
+				vkDeviceWaitIdle(lDevice);
+				collectGpuTimes(true);
 
-					renderPassInfo.renderArea.offset = {0, 0};
-					renderPassInfo.renderArea.extent = swapChainExtent;
+				double frameTime = frameTimeStats.distribution().quantile(0.5);
+				double gpuTime = gpuTimeStats.distribution().quantile(0.5);
+				if(!(gpuTime < CALIBRATION_GPU_SHARE * frameTime) || config.passes * 2 > MAX_PASSES){
+					break;
+				}
+			}
+			calibrating = false;
+			std::cout << shader << ": " << config.passes << " passes per frame" << std::endl;
+		}
 
-					VkClearValue clearColor = {0.0f, 0.0f, 0.0f, 1.0f}; //When clearing values use black.
-					renderPassInfo.clearValueCount = 1;
-					renderPassInfo.pClearValues = &clearColor;
+		void mainLoop(std::string shader){
+			finishVerification();
+			// Wall clock time, clock() would only count our own CPU time.
+			auto time = std::chrono::steady_clock::now();
+			auto start = time;
+			uint32_t frame = 0;
+			// Claim the sample memory now, nothing is allocated or written inside the loop.
+			recorder.reset(!config.keepSamples ? 0 : config.frameCount ? config.frameCount : RECORDER_CAPACITY);
+			frameTimeStats.reset(config.warmupFrames);
+			gpuTimeStats.reset(config.warmupFrames);
+			rampDetector.reset(config.windowFrames);
+			rampFrames = 0;
+			pipelineTotals = PipelineCounts();
+			pipelineFrames = 0;
+			frameInputs.frame = 0;
+			inputsStart = std::chrono::steady_clock::now();
+			convergedWindows = 0;
+			stopReason.clear();
+			for (; !shouldStop(frame, std::chrono::duration<float>(time - start).count()); frame++) {
+				if(!renderFrame(time)){
+					stopReason = "window closed";
+					break;
+				}
+			}
 
-					// Add render pass to command buffer
-					vkCmdBeginRenderPass(commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-					// Bind render pass to the pipeline
-					vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
-					// Draw things.
-					vkCmdDraw(commandBuffers[i], 6, 1, 0, 0);
-					// Finish the rendering.
-					vkCmdEndRenderPass(commandBuffers[i]);
+			vkDeviceWaitIdle(lDevice);
+			collectGpuTimes(true);
+			if(config.verify){
+				startVerification(shader);
+			}
+			if(config.keepSamples){
+				writeResults(shader + ".aule", makeResultsHeader(shader), recorder);
+				if(recorder.droppedCount() > 0){
+					std::cout << shader << ": recorder full, " << recorder.droppedCount() << " frames not recorded" << std::endl;
+				}
+			}
 
-					if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS) {
-						throw std::runtime_error("failed to record command buffer!");
-					}
+			std::cout << shader << ": ";
+			// Sustained rate, including the frames still queued when we started
+			// waiting, so a saturated GPU is what's being measured.
+			float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+			std::cout << frame << " frames in " << seconds << " s, " << frame / seconds << " frames/s ("
+				<< (config.latencyMode ? "latency" : std::to_string(config.framesInFlight) + " frames in flight")
+				<< "), stopped on " << stopReason << std::endl;
+			if(config.steadyState){
+				if(rampDetector.isSteady()){
+					std::cout << "  steady after " << rampFrames << " frames" << std::endl;
+				} else {
+					std::cout << "  never reached a steady state, the summary covers the whole run" << std::endl;
 				}
 			}
 
-			void createSemaphores(){
-				VkSemaphoreCreateInfo semaphoreInfo = {};
-				semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			writeSummary(shader);
+		}
 
-				if (vkCreateSemaphore(lDevice, &semaphoreInfo, nullptr, &imageAvailableSemaphore) != VK_SUCCESS ||
-					vkCreateSemaphore(lDevice, &semaphoreInfo, nullptr, &renderFinishedSemaphore) != VK_SUCCESS){
-					throw std::runtime_error("failed to create semaphores!");
+		// Every shader drawn from the one loop, in blocks of frames shuffled each
+		// round, so clock ramps, heat and whatever else the machine is doing fall
+		// on all of them alike and their relative cost stays meaningful. Each
+		// frame's times go to the shader it was drawn with.
+		void interleaveShaders(const std::vector<std::string>& shaders){
+			for(const std::string& shader : shaders){
+				shaderCompiled = isGlsl(shader);
+				if(config.compute){
+					createComputePipeline(shader);
+				} else {
+					createGraphicsPipeline(shader);
 				}
+				arms.emplace_back();
+				Arm& arm = arms.back();
+				arm.name = named(shader);
+				arm.pipeline = variantPipelines[0];
+				arm.layout = pipelineLayout;
+				arm.hash = shaderHash;
+				arm.stats = shaderStats;
+				arm.compiled = shaderCompiled;
 			}
+			createCommandBuffers();
 
-		void initVulkan(std::string shader){
-			createInstance();
-			setupDebugCallback();
-			createSurface();
+			// Warmup is a stretch of the run, shared between the shaders.
+			for(Arm& arm : arms){
+				arm.recorder.reset(!config.keepSamples ? 0 : config.frameCount ? config.frameCount : RECORDER_CAPACITY);
+				arm.frameTimeStats.reset(config.warmupFrames / arms.size());
+				arm.gpuTimeStats.reset(config.warmupFrames / arms.size());
+				arm.rampDetector.reset(config.windowFrames);
+			}
+			rampFrames = 0;
+			frameInputs.frame = 0;
+			inputsStart = std::chrono::steady_clock::now();
+			convergedWindows = 0;
+			stopReason.clear();
+
+			std::mt19937 random(config.seed);
+			std::vector<uint32_t> order(arms.size());
+			for(uint32_t a = 0; a < order.size(); a++){
+				order[a] = a;
+			}
+			size_t nextBlock = order.size();
+			uint32_t blockLeft = 0;
+
+			auto time = std::chrono::steady_clock::now();
+			auto start = time;
+			uint32_t frame = 0;
+			for (; !shouldStop(frame, std::chrono::duration<float>(time - start).count()); frame++) {
+				if(blockLeft == 0){
+					if(nextBlock == order.size()){
+						std::shuffle(order.begin(), order.end(), random);
+						nextBlock = 0;
+					}
+					currentArm = order[nextBlock++];
+					graphicsPipeline = computePipeline = arms[currentArm].pipeline;
+					pipelineLayout = arms[currentArm].layout;
+					blockLeft = config.blockFrames;
+				}
+				blockLeft--;
+				if(!renderFrame(time)){
+					stopReason = "window closed";
+					break;
+				}
+				arms[currentArm].frames++;
+			}
+			vkDeviceWaitIdle(lDevice);
+			collectGpuTimes(true);
+
+			float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+			std::cout << arms.size() << " shaders interleaved in blocks of " << config.blockFrames << ": "
+				<< frame << " frames in " << seconds << " s, stopped on " << stopReason << std::endl;
+			if(config.steadyState){
+				if(settled()){
+					std::cout << "  steady after " << rampFrames << " frames" << std::endl;
+				} else {
+					std::cout << "  never reached a steady state, the summaries cover the whole run" << std::endl;
+				}
+			}
 
-			selectPhysicalDevice();
-			createLogicalDevice();
-			
-			createSwapChain();
-			createImageViews();
-			
-			createRenderPass();
-			createGraphicsPipeline(shader);
-			
-			createFrameBuffers();
-			createCommandPool();
-			createCommandBuffers();
+			// The summary and results file are written from the members, so each
+			// shader's measurements take their turn there.
+			std::vector<Summary> gpuTimes;
+			for(Arm& arm : arms){
+				std::swap(recorder, arm.recorder);
+				std::swap(frameTimeStats, arm.frameTimeStats);
+				std::swap(gpuTimeStats, arm.gpuTimeStats);
+				pipelineTotals = arm.pipelineTotals;
+				pipelineFrames = arm.pipelineFrames;
+				shaderHash = arm.hash;
+				shaderStats = arm.stats;
+				shaderCompiled = arm.compiled;
+				graphicsPipeline = computePipeline = arm.pipeline;
+
+				if(config.keepSamples){
+					writeResults(arm.name + ".aule", makeResultsHeader(arm.name), recorder);
+					if(recorder.droppedCount() > 0){
+						std::cout << arm.name << ": recorder full, " << recorder.droppedCount() << " frames not recorded" << std::endl;
+					}
+				}
+				std::cout << arm.name << ": " << arm.frames << " frames" << std::endl;
+				writeSummary(arm.name);
+				gpuTimes.push_back(scaleSummary(gpuTimeStats.summarize(), 1.0 / config.passes));
+			}
+
+			// Relative to the first shader given, the baseline.
+			std::ofstream csv(arms[0].name + ".interleaved.csv");
+			csv << "shader,frames,median_gpu_time_us,median_ci_low_us,median_ci_high_us,relative\n";
+			std::cout << "median GPU time per pass, in microseconds, relative to " << arms[0].name << std::endl;
+			for(size_t a = 0; a < arms.size(); a++){
+				double relative = gpuTimes[a].median / gpuTimes[0].median;
+				std::cout << "  " << arms[a].name << ": " << gpuTimes[a].median
+					<< " [" << gpuTimes[a].medianLow << ", " << gpuTimes[a].medianHigh << "] x" << relative << std::endl;
+				csv << arms[a].name << "," << arms[a].frames << "," << gpuTimes[a].median << "," << gpuTimes[a].medianLow << ","
+					<< gpuTimes[a].medianHigh << "," << relative << "\n";
+			}
 
-			createSemaphores();
+			vkFreeCommandBuffers(lDevice, commandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+			for(const Arm& arm : arms){
+				vkDestroyPipeline(lDevice, arm.pipeline, nullptr);
+				vkDestroyPipelineLayout(lDevice, arm.layout, nullptr);
+			}
+			arms.clear();
 		}
 
-			void drawFrame(){
-				uint32_t imageIndex;
-				//Take an image from the swapchain, once available
-				vkAcquireNextImageKHR(lDevice, swapChain, std::numeric_limits<uint64_t>::max(),
-						imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
+		// Draw the shader until stopped, rebuilding it whenever its file changes.
+		// The new pipeline is built on another thread while the old one keeps
+		// drawing, then swapped in between frames, so device, images and command
+		// pool all stay. GPU time medians are printed every window, and the first
+		// window after a swap is compared with the last one before it.
+		void watchLoop(const std::string& name, const std::string& shader){
+#ifdef __linux__
+			// Editors often save by renaming over the file, so watch its directory.
+			std::filesystem::path path(shader);
+			std::string directory = path.has_parent_path() ? path.parent_path().string() : ".";
+			int watchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			if(watchFd < 0 || inotify_add_watch(watchFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0){
+				throw std::runtime_error("failed to watch " + directory + "!");
+			}
 
-				//Render an image, once needed
-				VkSubmitInfo submitInfo = {};
-				submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			recorder.reset(0);
+			frameTimeStats.reset(0);
+			gpuTimeStats.reset(0);
+			rampDetector.reset(config.windowFrames);
+			stopReason.clear();
+			std::future<Rebuild> rebuild;
+			bool changed = false;
+			double lastWindow_us = 0.0;
+			double before_us = 0.0; // Last window of the shader just replaced, until the new one has a window
+			uint32_t windowStart = 0;
+			auto time = std::chrono::steady_clock::now();
+			auto start = time;
+			std::cout << "watching " << shader << ", GPU time medians every " << config.windowFrames << " frames" << std::endl;
+			for(uint32_t frame = 0; !shouldStop(frame, std::chrono::duration<float>(time - start).count()); frame++){
+				if(!renderFrame(time)){
+					stopReason = "window closed";
+					break;
+				}
 
-				VkSemaphore waitSemaphores[] = {imageAvailableSemaphore};
-				VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-				submitInfo.waitSemaphoreCount = 1;
-				submitInfo.pWaitSemaphores = waitSemaphores;
-				submitInfo.pWaitDstStageMask = waitStages;
+				// One build at a time; an edit made during one starts another after it.
+				changed |= fileChanged(watchFd, path.filename().string());
+				if(changed && !rebuild.valid()){
+					changed = false;
+					rebuild = std::async(std::launch::async, [this, shader](){
+						auto buildStart = std::chrono::steady_clock::now();
+						Rebuild result;
+						result.pipelines = config.compute ? buildComputePipelines(shader, result.hash, result.stats, result.report)
+							: buildGraphicsPipelines(shader, result.hash, result.stats, result.report);
+						result.build_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+						return result;
+					});
+				}
 
-				submitInfo.commandBufferCount = 1;
-				submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
-				
-				VkSemaphore signalSemaphores[] = {renderFinishedSemaphore};
-				submitInfo.signalSemaphoreCount = 1;
-				submitInfo.pSignalSemaphores = signalSemaphores;
-				
-				if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
-					    throw std::runtime_error("failed to submit draw command buffer!");
+				if(rebuild.valid() && rebuild.wait_for(std::chrono::seconds(0)) == std::future_status::ready){
+					try {
+						Rebuild result = rebuild.get();
+						swapPipelines(result);
+						before_us = lastWindow_us;
+						windowStart = frame + 1;
+						std::cout << result.report << "\n" << name << ": rebuilt in " << result.build_ms << " ms, swapped in" << std::endl;
+					} catch(const std::exception& e){
+						std::cout << name << ": " << e.what() << "\n  still drawing the last version that built" << std::endl;
+					}
+				}
+
+				if(frame + 1 - windowStart == config.windowFrames){
+					windowStart = frame + 1;
+					lastWindow_us = gpuTimeStats.distribution().quantile(0.5);
+					std::cout << name << ": GPU " << lastWindow_us << " us, frame " << frameTimeStats.distribution().quantile(0.5) << " us";
+					if(before_us > 0.0){
+						std::cout << " (was " << before_us << " us, " << std::showpos << 100.0 * (lastWindow_us / before_us - 1.0)
+							<< std::noshowpos << "%)";
+						before_us = 0.0;
+					}
+					std::cout << std::endl;
+					frameTimeStats.reset(0);
+					gpuTimeStats.reset(0);
 				}
-				
-				//Put an image onto the swapchain
-				
-				VkPresentInfoKHR presentInfo = {};
-				presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-				
-				presentInfo.waitSemaphoreCount = 1;
-				presentInfo.pWaitSemaphores = signalSemaphores;
-				
-				VkSwapchainKHR swapChains[] = {swapChain};
-				presentInfo.swapchainCount = 1;
-				presentInfo.pSwapchains = swapChains;
-				presentInfo.pImageIndices = &imageIndex;
-				
-			    vkQueuePresentKHR(presentQueue, &presentInfo);
-				vkQueueWaitIdle(presentQueue);
 			}
 
-		void mainLoop(std::string shader){
-			clock_t time = clock();
-			std::ofstream dataFile;
-			dataFile.open(shader.append(".data"));
-			while (!glfwWindowShouldClose(window)) {
-				glfwPollEvents();
-				drawFrame();
-				float frameTime_us = float(clock() - time) * 1000000.0 / CLOCKS_PER_SEC;
-				dataFile << std::to_string(frameTime_us) << "\n";
-				time = clock();
+			vkDeviceWaitIdle(lDevice);
+			collectGpuTimes(true);
+			if(rebuild.valid()){
+				try {
+					for(VkPipeline pipeline : rebuild.get().pipelines){
+						vkDestroyPipeline(lDevice, pipeline, nullptr);
+					}
+				} catch(const std::exception&){
+				}
 			}
-			
-			dataFile.close();
+			close(watchFd);
+#else
+			throw std::runtime_error("--watch uses inotify, which needs Linux");
+#endif
+		}
+
+#ifdef __linux__
+		// Reads every queued inotify event, true if any were for the file.
+		static bool fileChanged(int watchFd, const std::string& filename){
+			alignas(inotify_event) char buffer[4096];
+			bool changed = false;
+			ssize_t length;
+			while((length = read(watchFd, buffer, sizeof(buffer))) > 0){
+				for(char* next = buffer; next < buffer + length; ){
+					inotify_event* event = reinterpret_cast<inotify_event*>(next);
+					if(event->len > 0 && filename == event->name){
+						changed = true;
+					}
+					next += sizeof(inotify_event) + event->len;
+				}
+			}
+			return changed;
+		}
+#endif
+
+		// Retire the shader's pipelines for a rebuild's. Waits for the frames
+		// still using the old ones, so their times are kept apart from the new.
+		void swapPipelines(const Rebuild& rebuild){
 			vkDeviceWaitIdle(lDevice);
+			collectGpuTimes(true);
+			vkFreeCommandBuffers(lDevice, commandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+			for(VkPipeline pipeline : variantPipelines){
+				vkDestroyPipeline(lDevice, pipeline, nullptr);
+			}
+			variantPipelines = rebuild.pipelines;
+			graphicsPipeline = computePipeline = variantPipelines[0];
+			shaderHash = rebuild.hash;
+			shaderStats = rebuild.stats;
+			createCommandBuffers();
+			frameTimeStats.reset(0);
+			gpuTimeStats.reset(0);
 		}
 		
 		void cleanup(){
 			//Synchronisation
-			vkDestroySemaphore(lDevice, renderFinishedSemaphore, nullptr);
-			vkDestroySemaphore(lDevice, imageAvailableSemaphore, nullptr);
+			for (size_t i = 0; i < config.framesInFlight; i++) {
+				vkDestroySemaphore(lDevice, renderFinishedSemaphores[i], nullptr);
+				vkDestroySemaphore(lDevice, imageAvailableSemaphores[i], nullptr);
+				vkDestroyFence(lDevice, inFlightFences[i], nullptr);
+			}
 
 			//Drawing
+			vkDestroyQueryPool(lDevice, timestampPool, nullptr);
+			if(statisticsPool != VK_NULL_HANDLE){
+				vkDestroyQueryPool(lDevice, statisticsPool, nullptr);
+			}
 			vkDestroyCommandPool(lDevice, commandPool, nullptr);
 			for (auto framebuffer : swapChainFramebuffers) {
 				vkDestroyFramebuffer(lDevice, framebuffer, nullptr);
 			}
 
-			//Destroy pipeline
-			vkDestroyPipeline(lDevice, graphicsPipeline, nullptr);
-			vkDestroyPipelineLayout(lDevice, pipelineLayout, nullptr);
-			vkDestroyRenderPass(lDevice, renderPass, nullptr);
+			//Verification
+			if(config.verify){
+				destroyVerifyBuffers();
+				vkDestroyBuffer(lDevice, verifyResultBuffer, nullptr);
+				vkFreeMemory(lDevice, verifyResultMemory, nullptr);
+				vkDestroyFence(lDevice, verifyFence, nullptr);
+				vkDestroyPipeline(lDevice, verifyPipeline, nullptr);
+				vkDestroyPipelineLayout(lDevice, verifyPipelineLayout, nullptr);
+				vkDestroyDescriptorPool(lDevice, verifyDescriptorPool, nullptr);
+				vkDestroyDescriptorSetLayout(lDevice, verifySetLayout, nullptr);
+			}
+
+			//Frame inputs, unmapped along with their memory
+			for(size_t i = 0; i < inputsBuffers.size(); i++){
+				vkDestroyBuffer(lDevice, inputsBuffers[i], nullptr);
+				vkFreeMemory(lDevice, inputsMemory[i], nullptr);
+			}
+			vkDestroyDescriptorPool(lDevice, inputsDescriptorPool, nullptr);
+			vkDestroyDescriptorSetLayout(lDevice, inputsSetLayout, nullptr);
+
+			//Fragment shader resources
+			for(size_t i = 0; i < resourceImages.size(); i++){
+				vkDestroySampler(lDevice, resourceSamplers[i], nullptr);
+				vkDestroyImageView(lDevice, resourceImageViews[i], nullptr);
+				vkDestroyImage(lDevice, resourceImages[i], nullptr);
+			}
+			for(VkBuffer buffer : resourceBuffers){
+				vkDestroyBuffer(lDevice, buffer, nullptr);
+			}
+			for(VkDeviceMemory memory : resourceMemory){
+				vkFreeMemory(lDevice, memory, nullptr);
+			}
+			vkDestroyDescriptorPool(lDevice, resourceDescriptorPool, nullptr);
+			vkDestroyDescriptorSetLayout(lDevice, resourceSetLayout, nullptr);
+			vkDestroyDescriptorSetLayout(lDevice, emptySetLayout, nullptr);
+
+			//Compute resources
+			for(size_t i = 0; i < computeImages.size(); i++){
+				vkDestroyImageView(lDevice, computeImageViews[i], nullptr);
+				vkDestroyImage(lDevice, computeImages[i], nullptr);
+			}
+			for(VkBuffer buffer : computeBuffers){
+				vkDestroyBuffer(lDevice, buffer, nullptr);
+			}
+			for(VkDeviceMemory memory : computeMemory){
+				vkFreeMemory(lDevice, memory, nullptr);
+			}
+			vkDestroyDescriptorPool(lDevice, computeDescriptorPool, nullptr);
+			vkDestroyDescriptorSetLayout(lDevice, computeSetLayout, nullptr);
+
+			//Destroy render pass, the pipelines went with their shaders
+			if(!config.compute){
+				vkDestroyRenderPass(lDevice, renderPass, nullptr);
+			}
 			
 			//Destroy swapchain
 			for(auto imageView : swapChainImageViews){
 				vkDestroyImageView(lDevice, imageView, nullptr);
 			}
-			vkDestroySwapchainKHR(lDevice, swapChain, nullptr);
+			if(config.headless){
+				for(size_t i = 0; i < swapChainImages.size(); i++){
+					vkDestroyImage(lDevice, swapChainImages[i], nullptr);
+					vkFreeMemory(lDevice, offscreenImageMemory[i], nullptr);
+				}
+			} else {
+				vkDestroySwapchainKHR(lDevice, swapChain, nullptr);
+			}
 			
+			//Keep the compiled pipelines for next time
+			savePipelineCache();
+
 			//Destroy the vulkan instance
 			vkDestroyDevice(lDevice, nullptr);
 			
-			DestroyDebugUtilsMessengerEXT(instance, callback, nullptr);
+			if(callback != VK_NULL_HANDLE){
+				DestroyDebugUtilsMessengerEXT(instance, callback, nullptr);
+			}
 			
-			vkDestroySurfaceKHR(instance, surface, nullptr);
+			if(!config.headless){
+				vkDestroySurfaceKHR(instance, surface, nullptr);
+			}
 			vkDestroyInstance(instance, nullptr);
+			logger.stop();
 
 			//Close the window
-		    glfwDestroyWindow(window);
-			glfwTerminate();	
+			if(!config.headless){
+				glfwDestroyWindow(window);
+				glfwTerminate();
+			}
 		}
 	};
 
+	// A shader argument may be a single SPIR-V or GLSL file, or a directory of them.
+	void addShaders(const std::string& path, std::vector<std::string>& shaders){
+		if(!std::filesystem::is_directory(path)){
+			shaders.push_back(path);
+			return;
+		}
+
+		std::vector<std::string> found;
+		for(const auto& entry : std::filesystem::directory_iterator(path)){
+			// The vertex and verification shaders share the directory when running from the build.
+			std::string extension = entry.path().extension().string();
+			std::string filename = entry.path().filename().string();
+			bool shader = extension == ".spv" || extension == ".frag" || extension == ".comp";
+			if(shader && filename != "vert.spv" && filename != "verify.spv" && filename != "verify.comp"){
+				found.push_back(entry.path().string());
+			}
+		}
+		std::sort(found.begin(), found.end());
+		shaders.insert(shaders.end(), found.begin(), found.end());
+	}
+
+	// A list file names one shader (or directory) per line, # for comments.
+	void addShaderList(const std::string& listFile, std::vector<std::string>& shaders){
+		std::ifstream list(listFile);
+		if(!list.is_open()){
+			throw std::runtime_error("failed to open shader list " + listFile);
+		}
+
+		std::string line;
+		while(std::getline(list, line)){
+			if(!line.empty() && line[0] != '#'){
+				addShaders(line, shaders);
+			}
+		}
+	}
+
+	// WxH, or N for a square.
+	VkExtent2D parseExtent(const std::string& size){
+		size_t x = size.find('x');
+		VkExtent2D extent = {};
+		try {
+			if(x == std::string::npos){
+				extent.width = extent.height = std::stoul(size);
+			} else {
+				extent = {static_cast<uint32_t>(std::stoul(size.substr(0, x))), static_cast<uint32_t>(std::stoul(size.substr(x + 1)))};
+			}
+		} catch(const std::exception&){
+			throw std::runtime_error("bad size " + size + ", expected WxH or N");
+		}
+		if(extent.width == 0 || extent.height == 0){
+			throw std::runtime_error("bad size " + size + ", width and height must be above 0");
+		}
+		return extent;
+	}
+
+	// WxH|file.ppm[,format=F][,mips=N|full][,tiling=optimal|linear][,filter=linear|nearest][,data=P]
+	// for a texture, bytes|file[,data=P] for a storage buffer.
+	ResourceBinding parseResource(const std::string& spec, bool texture){
+		ResourceBinding resource;
+		resource.spec = spec;
+		resource.texture = texture;
+		resource.data = "noise";
+
+		std::vector<std::string> fields;
+		for(size_t start = 0; start <= spec.size(); ){
+			size_t end = std::min(spec.find(',', start), spec.size());
+			fields.push_back(spec.substr(start, end - start));
+			start = end + 1;
+		}
+		for(size_t f = 1; f < fields.size(); f++){
+			size_t equals = fields[f].find('=');
+			std::string key = fields[f].substr(0, equals);
+			std::string value = equals == std::string::npos ? "" : fields[f].substr(equals + 1);
+			if(key == "data"){
+				resource.data = value;
+			} else if(texture && key == "format"){
+				auto found = std::find_if(std::begin(textureFormats), std::end(textureFormats),
+						[&](const TextureFormat& format){ return value == format.name; });
+				if(found == std::end(textureFormats)){
+					throw std::runtime_error("unknown texture format " + value);
+				}
+				resource.format = found->format;
+			} else if(texture && key == "mips"){
+				resource.mipLevels = value == "full" ? 0 : std::stoul(value);
+			} else if(texture && key == "tiling" && (value == "optimal" || value == "linear")){
+				resource.tiling = value == "linear" ? VK_IMAGE_TILING_LINEAR : VK_IMAGE_TILING_OPTIMAL;
+			} else if(texture && key == "filter" && (value == "linear" || value == "nearest")){
+				resource.filter = value == "nearest" ? VK_FILTER_NEAREST : VK_FILTER_LINEAR;
+			} else {
+				throw std::runtime_error("bad option " + fields[f] + " in " + spec);
+			}
+		}
+
+		// The size comes first, or from the file given instead.
+		bool fromFile = !fields[0].empty() && !std::isdigit(static_cast<unsigned char>(fields[0][0]));
+		if(fromFile){
+			resource.data = fields[0];
+		}
+		if(texture){
+			if(fromFile && std::filesystem::path(fields[0]).extension() != ".ppm"){
+				throw std::runtime_error("textures are read from binary PPM files, not " + fields[0]);
+			}
+			// A file's texture is the file's size, whatever was asked for.
+			if(std::filesystem::path(resource.data).extension() == ".ppm"){
+				readPpm(resource.data, resource.extent.width, resource.extent.height);
+			} else {
+				resource.extent = parseExtent(fields[0]);
+			}
+			if(resource.extent.width == 0 || resource.extent.height == 0){
+				throw std::runtime_error("empty texture " + spec);
+			}
+			if(resource.tiling == VK_IMAGE_TILING_LINEAR && resource.mipLevels != 1){
+				throw std::runtime_error("linear tiling only has the one mip, in " + spec);
+			}
+		} else {
+			resource.size = fromFile ? std::filesystem::file_size(fields[0]) : std::stoull(fields[0]);
+			if(resource.size == 0){
+				throw std::runtime_error("empty storage buffer " + spec);
+			}
+		}
+		return resource;
+	}
+
+	// id:type=v1,v2,... where type is int, uint, float or bool.
+	SpecConstant parseSpecConstant(const std::string& spec){
+		size_t colon = spec.find(':');
+		size_t equals = spec.find('=');
+		if(colon == std::string::npos || equals == std::string::npos || equals < colon){
+			throw std::runtime_error("bad specialization constant " + spec + ", expected id:type=v1,v2,...");
+		}
+
+		SpecConstant constant;
+		constant.id = std::stoul(spec.substr(0, colon));
+		std::string type = spec.substr(colon + 1, equals - colon - 1);
+		std::string values = spec.substr(equals + 1);
+		for(size_t start = 0; start <= values.size(); ){
+			size_t end = std::min(values.find(',', start), values.size());
+			std::string value = values.substr(start, end - start);
+			start = end + 1;
+
+			uint32_t bits;
+			if(type == "int"){
+				int32_t number = std::stoi(value);
+				memcpy(&bits, &number, sizeof(bits));
+			} else if(type == "uint"){
+				bits = std::stoul(value);
+			} else if(type == "float"){
+				float number = std::stof(value);
+				memcpy(&bits, &number, sizeof(bits));
+			} else if(type == "bool"){
+				bits = (value == "true" || value == "1") ? VK_TRUE : VK_FALSE;
+			} else {
+				throw std::runtime_error("unknown specialization constant type " + type);
+			}
+			constant.values.push_back(bits);
+			constant.names.push_back(value);
+		}
+		return constant;
+	}
+
+	// Aule [--headless] [--frames N] [--frames-in-flight N] [--latency] [--list file]
+	//      [--pipeline-cache-dir dir] [--no-pipeline-cache] [--warmup N] [--summary-only]
+	//      [--duration S] [--converge W] [--window N] [--stable-windows N] [--steady-state]
+	//      [--size WxH] [--sweep WxH,N,...] [--passes N|auto] [--instanced]
+	//      [--inputs] [--seed N] [--params file] [--spec id:type=v1,v2,...]...
+	//      [--verify] [--golden dir] [--write-golden] [--tolerance N]
+	//      [--device index|uuid|name] [--all-devices]
+	//      [--vertex file] [--opt 0|s|performance] [-D NAME[=VALUE]]... [--no-spirv-cache]
+	//      [--watch] [--profile measure|debug] [--heatmap CxR] [--executable-ir]
+	//      [--interleave] [--block N] [--texture spec]... [--ssbo spec]... shader.spv|.frag|dir...
+	// Aule --compute [--dispatch X,Y,Z] [--buffer bytes] [--image WxH] ... shader.spv|.comp|dir...
+	// Aule --convert results.aule...
+	// Aule --compare [--threshold R] [--alpha P] [--warmup N] before.aule after.aule
+	// Aule --list-devices
+	// GLSL (.frag, .vert, .comp) is compiled in process when built with SHADERC=1, and
+	// the SPIR-V kept in the pipeline cache directory for next time.
+	// With --inputs, shaders get FrameInputs as push constants, and a uniform buffer at
+	// set 0 binding 0 (set 1 for compute) holding them followed by the --params bytes
+	// at offset UNIFORM_PARAMS_OFFSET.
+	// --texture and --ssbo bind a sampler2D or buffer at set 1, binding i for the
+	// i-th one given; see parseResource for their specs.
+	TestConfig parseArguments(int argc, char *argv[], std::vector<std::string>& shaders){
+		TestConfig config;
+
+		for(int i = 1; i < argc; i++){
+			std::string arg = argv[i];
+			if(arg == "--headless"){
+				config.headless = true;
+			} else if(arg == "--frames" && i + 1 < argc){
+				config.frameCount = std::stoul(argv[++i]);
+			} else if(arg == "--frames-in-flight" && i + 1 < argc){
+				config.framesInFlight = std::stoul(argv[++i]);
+			} else if(arg == "--latency"){
+				config.latencyMode = true;
+			} else if(arg == "--pipeline-cache-dir" && i + 1 < argc){
+				config.pipelineCacheDir = argv[++i];
+			} else if(arg == "--no-pipeline-cache"){
+				config.pipelineCache = false;
+			} else if(arg == "--convert"){
+				config.convert = true;
+			} else if(arg == "--compare"){
+				config.compare = true;
+			} else if(arg == "--threshold" && i + 1 < argc){
+				config.compareThreshold = std::stod(argv[++i]);
+			} else if(arg == "--alpha" && i + 1 < argc){
+				config.compareAlpha = std::stod(argv[++i]);
+			} else if(arg == "--warmup" && i + 1 < argc){
+				config.warmupFrames = std::stoul(argv[++i]);
+			} else if(arg == "--summary-only"){
+				config.keepSamples = false;
+			} else if(arg == "--duration" && i + 1 < argc){
+				config.duration = std::stod(argv[++i]);
+			} else if(arg == "--converge" && i + 1 < argc){
+				config.convergeTarget = std::stod(argv[++i]);
+			} else if(arg == "--window" && i + 1 < argc){
+				config.windowFrames = std::stoul(argv[++i]);
+			} else if(arg == "--stable-windows" && i + 1 < argc){
+				config.stableWindows = std::stoul(argv[++i]);
+			} else if(arg == "--steady-state"){
+				config.steadyState = true;
+			} else if(arg == "--size" && i + 1 < argc){
+				VkExtent2D size = parseExtent(argv[++i]);
+				config.width = size.width;
+				config.height = size.height;
+			} else if(arg == "--passes" && i + 1 < argc){
+				std::string passes = argv[++i];
+				if(passes == "auto"){
+					config.calibratePasses = true;
+				} else {
+					config.passes = std::stoul(passes);
+				}
+			} else if(arg == "--instanced"){
+				config.instanced = true;
+			} else if(arg == "--inputs"){
+				config.inputs = true;
+			} else if(arg == "--seed" && i + 1 < argc){
+				config.seed = std::stoul(argv[++i]);
+			} else if(arg == "--params" && i + 1 < argc){
+				config.paramsFile = argv[++i];
+				config.inputs = true;
+			} else if(arg == "--spec" && i + 1 < argc){
+				config.specConstants.push_back(parseSpecConstant(argv[++i]));
+			} else if(arg == "--verify"){
+				config.verify = true;
+			} else if(arg == "--golden" && i + 1 < argc){
+				config.goldenDir = argv[++i];
+				config.verify = true;
+			} else if(arg == "--write-golden"){
+				config.writeGolden = true;
+				config.verify = true;
+			} else if(arg == "--tolerance" && i + 1 < argc){
+				config.tolerance = std::stoul(argv[++i]);
+			} else if(arg == "--device" && i + 1 < argc){
+				config.device = argv[++i];
+			} else if(arg == "--all-devices"){
+				config.allDevices = true;
+			} else if(arg == "--list-devices"){
+				config.listDevices = true;
+				config.headless = true;
+			} else if(arg == "--profile" && i + 1 < argc){
+				std::string profile = argv[++i];
+				if(profile != "measure" && profile != "debug"){
+					throw std::runtime_error("--profile is measure or debug");
+				}
+				config.debug = profile == "debug";
+			} else if(arg == "--heatmap" && i + 1 < argc){
+				config.heatmap = parseExtent(argv[++i]);
+			} else if(arg == "--interleave"){
+				config.interleave = true;
+			} else if(arg == "--block" && i + 1 < argc){
+				config.blockFrames = std::stoul(argv[++i]);
+			} else if(arg == "--executable-ir"){
+				config.executableIr = true;
+			} else if(arg == "--watch"){
+				config.watch = true;
+			} else if(arg == "--vertex" && i + 1 < argc){
+				config.vertexShader = argv[++i];
+			} else if(arg == "--opt" && i + 1 < argc){
+				config.compile.optimization = argv[++i];
+				if(config.compile.optimization != "0" && config.compile.optimization != "s" && config.compile.optimization != "performance"){
+					throw std::runtime_error("--opt is 0, s or performance");
+				}
+			} else if(arg == "-D" && i + 1 < argc){
+				config.compile.defines.push_back(argv[++i]);
+			} else if(arg.size() > 2 && arg.compare(0, 2, "-D") == 0){
+				config.compile.defines.push_back(arg.substr(2));
+			} else if(arg == "--no-spirv-cache"){
+				config.compile.cache = false;
+			} else if(arg == "--compute"){
+				config.compute = true;
+			} else if(arg == "--dispatch" && i + 1 < argc){
+				std::string groups = argv[++i];
+				size_t start = 0;
+				for(int axis = 0; axis < 3 && start <= groups.size(); axis++){
+					size_t end = std::min(groups.find(',', start), groups.size());
+					config.dispatch[axis] = std::stoul(groups.substr(start, end - start));
+					start = end + 1;
+				}
+			} else if(arg == "--buffer" && i + 1 < argc){
+				ComputeBinding binding;
+				binding.size = std::stoull(argv[++i]);
+				config.bindings.push_back(binding);
+			} else if(arg == "--image" && i + 1 < argc){
+				ComputeBinding binding;
+				binding.image = true;
+				binding.extent = parseExtent(argv[++i]);
+				config.bindings.push_back(binding);
+			} else if(arg == "--texture" && i + 1 < argc){
+				config.resources.push_back(parseResource(argv[++i], true));
+			} else if(arg == "--ssbo" && i + 1 < argc){
+				config.resources.push_back(parseResource(argv[++i], false));
+			} else if(arg == "--sweep" && i + 1 < argc){
+				std::string sizes = argv[++i];
+				for(size_t start = 0; start <= sizes.size(); ){
+					size_t end = std::min(sizes.find(',', start), sizes.size());
+					config.sweep.push_back(parseExtent(sizes.substr(start, end - start)));
+					start = end + 1;
+				}
+			} else if(arg == "--list" && i + 1 < argc){
+				addShaderList(argv[++i], shaders);
+			} else {
+				addShaders(arg, shaders);
+			}
+		}
+
+		// A vertex shader among the shaders replaces the full screen quad's.
+		for(auto it = shaders.begin(); it != shaders.end(); ){
+			if(std::filesystem::path(*it).extension() == ".vert"){
+				config.vertexShader = *it;
+				it = shaders.erase(it);
+			} else {
+				++it;
+			}
+		}
+
+		// Compute shaders given as GLSL say which mode we're in.
+		size_t computeSources = std::count_if(shaders.begin(), shaders.end(), [](const std::string& shader){
+			return std::filesystem::path(shader).extension() == ".comp";
+		});
+		if(computeSources > 0){
+			if(computeSources != shaders.size()){
+				throw std::runtime_error(".comp and fragment shaders can't be measured in the same run");
+			}
+			config.compute = true;
+		}
+		config.compile.cacheDir = config.pipelineCacheDir;
+
+		if(shaders.empty() && !config.listDevices){
+			throw std::runtime_error(std::string("usage: ") + argv[0] +
+					" [--headless] [--frames N] [--frames-in-flight N] [--latency] [--list file]"
+					" [--pipeline-cache-dir dir] [--no-pipeline-cache] [--warmup N] [--summary-only]"
+					" [--duration S] [--converge W] [--window N] [--stable-windows N] [--steady-state]"
+					" [--size WxH] [--sweep WxH,N,...] [--passes N|auto] [--instanced]"
+					" [--inputs] [--seed N] [--params file] [--spec id:type=v1,v2,...]..."
+					" [--verify] [--golden dir] [--write-golden] [--tolerance N]"
+					" [--device index|uuid|name] [--all-devices]"
+					" [--vertex file] [--opt 0|s|performance] [-D NAME[=VALUE]]... [--no-spirv-cache]"
+					" [--watch] [--profile measure|debug] [--heatmap CxR] [--executable-ir]"
+					" [--interleave] [--block N] [--texture spec]... [--ssbo spec]... shader.spv|.frag|dir...\n"
+					"       " + argv[0] + " --compute [--dispatch X,Y,Z] [--buffer bytes] [--image WxH] ... shader.spv|.comp|dir...\n"
+					"       " + argv[0] + " --convert results.aule...\n"
+					"       " + argv[0] + " --compare [--threshold R] [--alpha P] [--warmup N] before.aule after.aule\n"
+					"       " + argv[0] + " --list-devices");
+		}
+
+		if(config.compare && shaders.size() != 2){
+			throw std::runtime_error("--compare takes two results files, before and after");
+		}
+
+		if(config.framesInFlight < 1 || config.framesInFlight > MAX_FRAMES_IN_FLIGHT){
+			throw std::runtime_error("frames in flight must be between 1 and " + std::to_string(MAX_FRAMES_IN_FLIGHT));
+		}
+
+		// Latency mode is the serialised loop, nothing is queued ahead.
+		if(config.latencyMode){
+			config.framesInFlight = 1;
+		}
+
+		if(config.passes < 1 || config.passes > MAX_PASSES){
+			throw std::runtime_error("passes must be between 1 and " + std::to_string(MAX_PASSES));
+		}
+
+		// There is nothing to show for a compute shader.
+		if(config.compute){
+			config.headless = true;
+			if(!config.resources.empty()){
+				throw std::runtime_error("--texture and --ssbo are for fragment shaders, compute shaders bind --buffer and --image");
+			}
+			if(!config.sweep.empty()){
+				throw std::runtime_error("--sweep is for fragment shaders, compute shaders set their size with --dispatch");
+			}
+		}
+
+		// One window is all we can show.
+		if(config.allDevices && !config.headless){
+			throw std::runtime_error("--all-devices runs devices side by side, it needs --headless");
+		}
+
+		// Only offscreen images are made to be copied from.
+		if(config.verify && (!config.headless || config.compute)){
+			throw std::runtime_error("--verify checks offscreen frames, it needs --headless and a fragment shader");
+		}
+
+		// Golden images are shared between devices, so only one may write them.
+		if(config.writeGolden && config.allDevices){
+			throw std::runtime_error("--write-golden writes one image per shader, run it on one device, without --all-devices");
+		}
+
+		if(!config.sweep.empty() && !config.specConstants.empty()){
+			throw std::runtime_error("sweep sizes or specialization variants, not both at once");
+		}
+
+		if(!config.sweep.empty() && !config.headless){
+			throw std::runtime_error("--sweep resizes offscreen images, it needs --headless");
+		}
+
+		if(config.watch && (shaders.size() != 1 || !config.specConstants.empty() || !config.sweep.empty() || config.verify || config.allDevices)){
+			throw std::runtime_error("--watch takes one shader, without --spec, --sweep, --verify or --all-devices");
+		}
+
+		// Tiles are drawn into an offscreen image, outside the frame loop.
+		if(config.heatmap.width > 0 && (!config.headless || config.compute || config.watch ||
+				!config.sweep.empty() || !config.specConstants.empty())){
+			throw std::runtime_error("--heatmap times a fragment shader's tiles offscreen, it needs --headless, without --spec, --sweep or --watch");
+		}
+
+		// Interleaving draws every shader from one loop, with one pipeline each.
+		if(config.interleave && (shaders.size() < 2 || config.blockFrames < 1 || config.watch || config.verify ||
+				config.calibratePasses || config.heatmap.width > 0 || !config.sweep.empty() || !config.specConstants.empty())){
+			throw std::runtime_error("--interleave takes two or more shaders and a block of at least a frame,"
+					" without --spec, --sweep, --watch, --verify, --heatmap or --passes auto");
+		}
+
+		if(config.windowFrames < 2){
+			throw std::runtime_error("a window needs at least 2 frames");
+		}
+
+		// Converging means the clock ramp has to be out of the way first, and
+		// a shader that never settles still has to stop somewhere.
+		if(config.convergeTarget > 0.0){
+			config.steadyState = true;
+			if(config.frameCount == 0 && config.duration == 0.0){
+				config.frameCount = DEFAULT_MAX_FRAMES;
+			}
+		}
+
+		// With no window to close, or more shaders to get through, stop after a set number of frames.
+		// Watching goes on until stopped.
+		if((config.headless || shaders.size() > 1) && !config.watch && config.frameCount == 0 && config.duration == 0.0){
+			config.frameCount = DEFAULT_FRAME_COUNT;
+		}
+
+		return config;
+	}
+
+	// Per pass times in a column of a results file, without the warmup frames.
+	std::vector<double> passTimes(const std::vector<float>& times, const ResultsHeader& header, uint32_t warmupFrames){
+		double passes = std::max<uint32_t>(header.passes, 1);
+		size_t first = std::min<size_t>(warmupFrames, times.size());
+		std::vector<double> perPass;
+		perPass.reserve(times.size() - first);
+		for(size_t i = first; i < times.size(); i++){
+			perPass.push_back(times[i] / passes);
+		}
+		return perPass;
+	}
+
+	void printComparison(const std::string& label, const Comparison& comparison){
+		std::cout << "  " << label << ": median " << comparison.medianA << " -> " << comparison.medianB << " us, "
+			<< std::showpos << comparison.difference << std::noshowpos
+			<< " [" << comparison.differenceLow << ", " << comparison.differenceHigh << "] us ("
+			<< std::showpos << 100.0 * comparison.difference / comparison.medianA << std::noshowpos << "%)"
+			<< ", p " << comparison.p << ", P(after slower) " << comparison.superiority
+			<< " (" << comparison.countA << " vs " << comparison.countB << " frames)" << std::endl;
+	}
+
+	// Whether the second results file is slower than the first by more than run
+	// to run noise: a regression is a median GPU time per pass more than the
+	// threshold slower, which the rank test also finds significant. Files from
+	// different devices, drivers or sizes can be compared; what differs is shown.
+	int compareResults(const TestConfig& config, const std::string& before, const std::string& after){
+		std::vector<float> frameTimesA, gpuTimesA, frameTimesB, gpuTimesB;
+		ResultsHeader a = readResults(before, frameTimesA, gpuTimesA);
+		ResultsHeader b = readResults(after, frameTimesB, gpuTimesB);
+
+		std::cout << before << " -> " << after << std::endl;
+		auto differs = [](const std::string& label, const std::string& valueA, const std::string& valueB){
+			if(valueA != valueB){
+				std::cout << "  " << label << ": " << valueA << " -> " << valueB << std::endl;
+			}
+		};
+		differs("shader", a.shaderName, b.shaderName);
+		differs("device", a.deviceName, b.deviceName);
+		differs("driver", std::to_string(a.driverVersion), std::to_string(b.driverVersion));
+		differs("size", std::to_string(a.width) + "x" + std::to_string(a.height), std::to_string(b.width) + "x" + std::to_string(b.height));
+		differs("passes", std::to_string(a.passes), std::to_string(b.passes));
+		differs("frames in flight", std::to_string(a.framesInFlight), std::to_string(b.framesInFlight));
+		differs("profile", a.profile == PROFILE_DEBUG ? "debug" : "measure", b.profile == PROFILE_DEBUG ? "debug" : "measure");
+
+		Comparison frameTime = compareSamples(passTimes(frameTimesA, a, config.warmupFrames), passTimes(frameTimesB, b, config.warmupFrames));
+		Comparison gpuTime = compareSamples(passTimes(gpuTimesA, a, config.warmupFrames), passTimes(gpuTimesB, b, config.warmupFrames));
+		if(gpuTime.countA == 0 || gpuTime.countB == 0){
+			throw std::runtime_error("no frames left after the warmup to compare");
+		}
+		printComparison("frame time per pass", frameTime);
+		printComparison("GPU time per pass", gpuTime);
+
+		// Without timestamps the GPU column is empty, and the frame time is all there is.
+		const Comparison& gated = gpuTime.medianA > 0.0 ? gpuTime : frameTime;
+		double slowdown = gated.difference / gated.medianA;
+		bool significant = gated.p < config.compareAlpha;
+		if(slowdown > config.compareThreshold && significant){
+			std::cout << "  regression: " << 100.0 * slowdown << "% slower, over the "
+				<< 100.0 * config.compareThreshold << "% threshold at p < " << config.compareAlpha << std::endl;
+			return EXIT_FAILURE;
+		}
+		std::cout << "  no regression: " << (significant ? "significant" : "not significant") << " change of "
+			<< std::showpos << 100.0 * slowdown << std::noshowpos << "%" << std::endl;
+		return EXIT_SUCCESS;
+	}
+
+	// The same run on every suitable device at once, a thread and logical device
+	// each, with the device's index and name added to every output.
+	int runOnAllDevices(const TestConfig& config, const std::vector<std::string>& shaders){
+		std::vector<std::pair<uint32_t, std::string>> devices = ShaderTester(config).suitableDevices();
+		if(devices.empty()){
+			throw std::runtime_error("No suitable GPUs found!");
+		}
+
+		std::vector<std::thread> threads;
+		std::vector<std::string> errors(devices.size());
+		for(size_t i = 0; i < devices.size(); i++){
+			TestConfig deviceConfig = config;
+			deviceConfig.device = std::to_string(devices[i].first);
+			deviceConfig.deviceLabel = std::to_string(devices[i].first) + "-" + devices[i].second;
+			std::replace(deviceConfig.deviceLabel.begin(), deviceConfig.deviceLabel.end(), ' ', '_');
+			std::replace(deviceConfig.deviceLabel.begin(), deviceConfig.deviceLabel.end(), '/', '_');
+
+			threads.emplace_back([deviceConfig, &shaders, &errors, i](){
+				try {
+					ShaderTester testbed(deviceConfig);
+					testbed.run(shaders);
+				} catch (const std::exception& e) {
+					errors[i] = e.what();
+				}
+			});
+		}
+		for(std::thread& thread : threads){
+			thread.join();
+		}
+
+		int result = EXIT_SUCCESS;
+		for(size_t i = 0; i < devices.size(); i++){
+			if(!errors[i].empty()){
+				std::cerr << devices[i].second << ": " << errors[i] << std::endl;
+				result = EXIT_FAILURE;
+			}
+		}
+		return result;
+	}
+
 	//Create and run all the tests
 	int main(int argc, char *argv[]){	
     	
-		ShaderTester testbed;
-
 		try {
-			testbed.run(argv[1]);
+			std::vector<std::string> shaders;
+			TestConfig config = parseArguments(argc, argv, shaders);
+
+			if(config.convert){
+				for(const std::string& results : shaders){
+					convertResults(results);
+				}
+				return EXIT_SUCCESS;
+			}
+
+			if(config.compare){
+				return compareResults(config, shaders[0], shaders[1]);
+			}
+
+			if(config.listDevices){
+				ShaderTester(config).listDevices();
+				return EXIT_SUCCESS;
+			}
+
+			if(config.allDevices){
+				return runOnAllDevices(config, shaders);
+			}
+
+			ShaderTester testbed(config);
+			testbed.run(shaders);
 		} catch (const std::exception& e) {
 			std::cerr << e.what() << std::endl;
 			return EXIT_FAILURE;
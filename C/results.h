@@ -0,0 +1,174 @@
+#ifndef AULE_RESULTS_H
+#define AULE_RESULTS_H
+
+// Recording frame times without disturbing the frames being timed, and the
+// binary results files they end up in.
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+#ifdef __linux__
+#include <unistd.h> // getpid
+#endif
+
+#define RESULTS_MAGIC "AULE"
+#define RESULTS_VERSION 1
+#define RECORDER_CAPACITY (1 << 20) // Samples kept when the run length isn't known up front
+#define PROFILE_MEASURE 0 // No layers or debug messages
+#define PROFILE_DEBUG 1 // Validation layers, messages logged on their own thread
+
+	// Describes the run, so a results file makes sense on its own.
+	// Followed by one column of floats per measurement, sampleCount long.
+	struct ResultsHeader {
+		char magic[4];
+		uint32_t version;
+		char deviceName[256];
+		char shaderName[256];
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint32_t driverVersion;
+		uint32_t width;
+		uint32_t height;
+		int32_t presentMode; // VkPresentModeKHR, -1 when headless
+		uint32_t profile; // PROFILE_MEASURE, or PROFILE_DEBUG with validation (as every file from before profiles)
+		uint32_t framesInFlight; // 1 is latency mode
+		uint64_t spirvHash; // FNV-1a of the fragment shader's SPIR-V
+		uint64_t sampleCount;
+		uint32_t columnCount; // CPU frame time, then GPU time, in microseconds
+		uint32_t passes; // Full screen passes per frame, 0 in files from before there was a choice
+	};
+	static_assert(sizeof(ResultsHeader) == 576, "results header layout changed");
+
+	// 64 bit FNV-1a, enough to tell shaders apart.
+	inline uint64_t hashBytes(const char* data, size_t size){
+		uint64_t hash = 14695981039346656037ull;
+		for(size_t i = 0; i < size; i++){
+			hash ^= static_cast<uint8_t>(data[i]);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	// A name beside path to write to before renaming over it, one per thread
+	// of each process, so runs sharing a cache never write the same file.
+	inline std::string partPath(const std::string& path){
+		std::string part = path + ".";
+#ifdef __linux__
+		part += std::to_string(getpid()) + ".";
+#endif
+		return part + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+	}
+
+	// Fixed size sample store. All the memory is claimed before the run, so
+	// recording a frame never allocates; anything past capacity is counted
+	// and dropped rather than grown into.
+	class FrameRecorder {
+	public:
+		void reset(size_t capacity){
+			frameTimes.assign(capacity, 0.0f);
+			gpuTimes.assign(capacity, 0.0f);
+			count = 0;
+			dropped = 0;
+		}
+
+		void record(float frameTime_us, float gpuTime_us){
+			if(count == frameTimes.size()){
+				dropped++;
+				return;
+			}
+			frameTimes[count] = frameTime_us;
+			gpuTimes[count] = gpuTime_us;
+			count++;
+		}
+
+		size_t size() const { return count; }
+		size_t droppedCount() const { return dropped; }
+		const float* frameTimeData() const { return frameTimes.data(); }
+		const float* gpuTimeData() const { return gpuTimes.data(); }
+
+	private:
+		std::vector<float> frameTimes;
+		std::vector<float> gpuTimes;
+		size_t count = 0;
+		size_t dropped = 0;
+	};
+
+	inline void writeResults(const std::string& filename, ResultsHeader header, const FrameRecorder& recorder){
+		memcpy(header.magic, RESULTS_MAGIC, 4);
+		header.version = RESULTS_VERSION;
+		header.sampleCount = recorder.size();
+		header.columnCount = 2;
+
+		std::ofstream file(filename, std::ios::binary);
+		if(!file.is_open()){
+			throw std::runtime_error("failed to open " + filename);
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(recorder.frameTimeData()), recorder.size() * sizeof(float));
+		file.write(reinterpret_cast<const char*>(recorder.gpuTimeData()), recorder.size() * sizeof(float));
+	}
+
+	// Read a results file back, one vector per column.
+	inline ResultsHeader readResults(const std::string& filename, std::vector<float>& frameTimes, std::vector<float>& gpuTimes){
+		std::ifstream file(filename, std::ios::binary);
+		if(!file.is_open()){
+			throw std::runtime_error("failed to open " + filename);
+		}
+
+		ResultsHeader header;
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+		if(!file || memcmp(header.magic, RESULTS_MAGIC, 4) != 0 || header.version != RESULTS_VERSION){
+			throw std::runtime_error(filename + " is not a results file");
+		}
+
+		// Check the count against what the file holds before allocating for it
+		std::streampos columns = file.tellg();
+		file.seekg(0, std::ios::end);
+		uint64_t remaining = static_cast<uint64_t>(file.tellg() - columns);
+		file.seekg(columns);
+		if(header.sampleCount > remaining / (2 * sizeof(float))){
+			throw std::runtime_error(filename + " is truncated");
+		}
+
+		frameTimes.resize(header.sampleCount);
+		gpuTimes.resize(header.sampleCount);
+		file.read(reinterpret_cast<char*>(frameTimes.data()), header.sampleCount * sizeof(float));
+		file.read(reinterpret_cast<char*>(gpuTimes.data()), header.sampleCount * sizeof(float));
+		if(!file){
+			throw std::runtime_error(filename + " is truncated");
+		}
+
+		return header;
+	}
+
+	// Back to the plain text .data files, one frame time per line, with the
+	// GPU times alongside in .gpu.data.
+	inline void convertResults(const std::string& filename){
+		std::vector<float> frameTimes;
+		std::vector<float> gpuTimes;
+		readResults(filename, frameTimes, gpuTimes);
+
+		std::string base = filename.substr(0, filename.rfind(".aule"));
+		std::ofstream dataFile(base + ".data");
+		if(!dataFile.is_open()){
+			throw std::runtime_error("failed to open " + base + ".data");
+		}
+		for(float frameTime_us : frameTimes){
+			dataFile << std::to_string(frameTime_us) << "\n";
+		}
+
+		std::ofstream gpuFile(base + ".gpu.data");
+		if(!gpuFile.is_open()){
+			throw std::runtime_error("failed to open " + base + ".gpu.data");
+		}
+		for(float gpuTime_us : gpuTimes){
+			gpuFile << std::to_string(gpuTime_us) << "\n";
+		}
+	}
+
+#endif
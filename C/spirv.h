@@ -0,0 +1,294 @@
+#ifndef AULE_SPIRV_H
+#define AULE_SPIRV_H
+
+// What can be told about a shader's cost without running it: a single pass
+// over the SPIR-V words, counting instructions by kind, loops and their
+// nesting, decorations, and roughly how many values are alive at once.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include "stats.h" // jsonString
+
+#define SPIRV_MAGIC 0x07230203
+#define SPIRV_FIRST_TRANSCENDENTAL 13 // GLSL.std.450 Sin, through
+#define SPIRV_LAST_TRANSCENDENTAL 32 // InverseSqrt
+
+	struct SpirvStats {
+		uint32_t version = 0;
+		uint32_t bound = 0; // Every id is below this
+		uint32_t functions = 0;
+		uint32_t instructions = 0; // In function bodies, debug lines left out
+
+		// Instruction mix, in function bodies
+		uint32_t alu = 0; // Arithmetic, conversions, comparisons, bit ops and GLSL.std.450 maths
+		uint32_t transcendental = 0; // GLSL.std.450 trigonometry, exp, log, pow and square roots
+		uint32_t texture = 0; // Samples, fetches, gathers and image reads
+		uint32_t derivative = 0; // dFdx, dFdy and fwidth
+		uint32_t branch = 0; // Branches, switches and discards
+		uint32_t memory = 0; // Loads, stores, access chains, image writes and atomics
+		uint32_t call = 0;
+		uint32_t other = 0;
+
+		uint32_t loops = 0;
+		uint32_t maxLoopDepth = 0;
+		uint32_t unrollHints = 0; // Loops marked Unroll
+
+		// Pressure estimates
+		uint32_t functionVariables = 0; // OpVariable in Function storage
+		uint32_t peakLiveScalars = 0; // Most scalar components alive at once, over straight-line order
+
+		std::map<std::string, uint32_t> decorations; // By name, member decorations included
+	};
+
+	// Names of the decorations worth knowing about for cost.
+	inline const char* decorationName(uint32_t decoration){
+		switch(decoration){
+			case 0: return "RelaxedPrecision";
+			case 1: return "SpecId";
+			case 11: return "BuiltIn";
+			case 13: return "NoPerspective";
+			case 14: return "Flat";
+			case 16: return "Centroid";
+			case 17: return "Sample";
+			case 18: return "Invariant";
+			case 19: return "Restrict";
+			case 24: return "NonWritable";
+			case 25: return "NonReadable";
+			case 30: return "Location";
+			case 33: return "Binding";
+			case 34: return "DescriptorSet";
+			case 42: return "NoContraction";
+			default: return "Other";
+		}
+	}
+
+	// Instructions inside a function that don't define a value.
+	inline bool hasNoResult(uint32_t opcode){
+		switch(opcode){
+			case 0: case 8: case 56: case 62: case 63: case 64: case 99: case 224: case 225: case 228:
+			case 246: case 247: case 248: case 249: case 250: case 251: case 252: case 253: case 254: case 255:
+			case 256: case 257: case 317: case 4416: case 5380:
+				return true;
+			default:
+				return (opcode >= 218 && opcode <= 221); // Geometry shader emits
+		}
+	}
+
+	inline SpirvStats analyzeSpirv(const std::vector<char>& code){
+		if(code.size() < 20 || code.size() % 4 != 0){
+			throw std::runtime_error("SPIR-V is not a whole number of words");
+		}
+		std::vector<uint32_t> words(code.size() / 4);
+		memcpy(words.data(), code.data(), code.size());
+		if(words[0] != SPIRV_MAGIC){
+			throw std::runtime_error("not SPIR-V, or the wrong way round");
+		}
+
+		SpirvStats stats;
+		stats.version = words[1];
+		stats.bound = words[3];
+		// Every id is defined by an instruction of a word or more, and id 0 stands
+		// in for operands out of range, so anything else is not a module to size for.
+		if(stats.bound == 0 || stats.bound > words.size()){
+			throw std::runtime_error("SPIR-V id bound " + std::to_string(stats.bound) + " does not fit the module");
+		}
+
+		// Scalar components of each type, and the type of each value.
+		std::vector<uint32_t> components(stats.bound, 0);
+		std::vector<uint32_t> typeOf(stats.bound, 0);
+		uint32_t glslStd450 = 0;
+
+		// Per function: where each value is made and last used, by instruction.
+		std::vector<int64_t> defined(stats.bound, -1);
+		std::vector<int64_t> lastUse(stats.bound, -1);
+		std::vector<uint32_t> functionIds;
+		struct OpenLoop { uint32_t merge; int64_t header; };
+		std::vector<OpenLoop> openLoops;
+		int64_t position = 0;
+		int64_t labelPosition = 0;
+		bool inFunction = false;
+
+		auto finishFunction = [&](){
+			// Everything alive across a stretch of the function, a scalar each.
+			std::vector<int64_t> change(position + 2, 0);
+			for(uint32_t id : functionIds){
+				if(lastUse[id] >= 0){
+					change[defined[id]] += components[typeOf[id]];
+					change[lastUse[id] + 1] -= components[typeOf[id]];
+				}
+			}
+			int64_t live = 0;
+			for(int64_t delta : change){
+				live += delta;
+				stats.peakLiveScalars = std::max<uint32_t>(stats.peakLiveScalars, static_cast<uint32_t>(std::max<int64_t>(live, 0)));
+			}
+			for(uint32_t id : functionIds){
+				defined[id] = lastUse[id] = -1;
+			}
+			functionIds.clear();
+			openLoops.clear();
+		};
+
+		for(size_t i = 5; i < words.size(); ){
+			uint32_t wordCount = words[i] >> 16;
+			uint32_t opcode = words[i] & 0xffff;
+			if(wordCount == 0 || i + wordCount > words.size()){
+				throw std::runtime_error("SPIR-V instruction runs past the end");
+			}
+			const uint32_t* operands = &words[i + 1];
+			uint32_t operandCount = wordCount - 1;
+			i += wordCount;
+
+			auto id = [&](uint32_t operand){ return operand < operandCount && operands[operand] < stats.bound ? operands[operand] : 0; };
+
+			switch(opcode){
+				case 11: // OpExtInstImport
+					if(operandCount > 1 && strncmp(reinterpret_cast<const char*>(&operands[1]), "GLSL.std.450", operandCount * 4 - 4) == 0){
+						glslStd450 = operands[0];
+					}
+					continue;
+				case 20: case 21: case 22: // OpTypeBool, OpTypeInt, OpTypeFloat
+					components[id(0)] = 1;
+					continue;
+				case 23: // OpTypeVector
+					components[id(0)] = operandCount > 2 ? operands[2] : 0;
+					continue;
+				case 24: // OpTypeMatrix, columns of vectors
+					components[id(0)] = operandCount > 2 ? components[id(1)] * operands[2] : 0;
+					continue;
+				case 71: case 72: // OpDecorate, OpMemberDecorate
+					if(operandCount > (opcode == 71 ? 1u : 2u)){
+						stats.decorations[decorationName(operands[opcode == 71 ? 1 : 2])]++;
+					}
+					continue;
+				case 54: // OpFunction
+					inFunction = true;
+					stats.functions++;
+					position = 0;
+					continue;
+				case 56: // OpFunctionEnd
+					finishFunction();
+					inFunction = false;
+					continue;
+			}
+			if(!inFunction || opcode == 8 || opcode == 317){ // OpLine and OpNoLine don't run
+				continue;
+			}
+
+			position++;
+
+			// Kind of work. Labels and merge declarations only give the blocks
+			// their structure.
+			bool structure = opcode == 246 || opcode == 247 || opcode == 248;
+			if(!structure){
+				stats.instructions++;
+			}
+			if(structure){
+				// Not work
+			} else if(opcode == 12){ // OpExtInst
+				uint32_t instruction = operandCount > 3 ? operands[3] : 0;
+				if(id(2) == glslStd450 && instruction >= SPIRV_FIRST_TRANSCENDENTAL && instruction <= SPIRV_LAST_TRANSCENDENTAL){
+					stats.transcendental++;
+				} else {
+					stats.alu++;
+				}
+			} else if((opcode >= 109 && opcode <= 124) || (opcode >= 126 && opcode <= 152) ||
+					(opcode >= 154 && opcode <= 191) || (opcode >= 194 && opcode <= 205) || opcode == 81 || opcode == 82 || opcode == 79 || opcode == 80){
+				stats.alu++; // Including vector shuffles and composites
+			} else if((opcode >= 87 && opcode <= 98) || (opcode >= 305 && opcode <= 315)){
+				stats.texture++;
+			} else if(opcode >= 207 && opcode <= 215){
+				stats.derivative++;
+			} else if(opcode >= 249 && opcode <= 252){
+				stats.branch++;
+			} else if((opcode >= 61 && opcode <= 66) || opcode == 99 || (opcode >= 227 && opcode <= 242)){
+				stats.memory++;
+			} else if(opcode == 57){
+				stats.call++;
+			} else {
+				stats.other++;
+			}
+
+			if(opcode == 59 && operandCount > 2 && operands[2] == 7){ // OpVariable, Function storage
+				stats.functionVariables++;
+			}
+
+			// Loops nest by their merge blocks: a loop is open until its merge
+			// block's label, and anything from before it used inside is alive
+			// for the whole loop.
+			if(opcode == 248){ // OpLabel
+				labelPosition = position;
+				while(!openLoops.empty() && openLoops.back().merge == id(0)){
+					for(uint32_t value : functionIds){
+						if(defined[value] < openLoops.back().header && lastUse[value] >= openLoops.back().header){
+							lastUse[value] = position;
+						}
+					}
+					openLoops.pop_back();
+				}
+				continue;
+			}
+			if(opcode == 246){ // OpLoopMerge
+				stats.loops++;
+				if(operandCount > 2 && (operands[2] & 1)){
+					stats.unrollHints++;
+				}
+				openLoops.push_back({id(0), labelPosition});
+				stats.maxLoopDepth = std::max<uint32_t>(stats.maxLoopDepth, static_cast<uint32_t>(openLoops.size()));
+				continue;
+			}
+
+			// Result type and id come first when there is a result.
+			uint32_t firstUse = 0;
+			if(!hasNoResult(opcode) && operandCount >= 2){
+				uint32_t result = id(1);
+				typeOf[result] = id(0);
+				defined[result] = position;
+				functionIds.push_back(result);
+				firstUse = 2;
+			}
+			for(uint32_t operand = firstUse; operand < operandCount; operand++){
+				uint32_t used = id(operand);
+				if(used != 0 && defined[used] >= 0){
+					lastUse[used] = position;
+				}
+			}
+		}
+
+		return stats;
+	}
+
+	inline void writeSpirvStatsJson(std::ostream& out, const SpirvStats& stats){
+		out << "{\"instructions\": " << stats.instructions
+			<< ", \"functions\": " << stats.functions
+			<< ", \"alu\": " << stats.alu
+			<< ", \"transcendental\": " << stats.transcendental
+			<< ", \"texture\": " << stats.texture
+			<< ", \"derivative\": " << stats.derivative
+			<< ", \"branch\": " << stats.branch
+			<< ", \"memory\": " << stats.memory
+			<< ", \"call\": " << stats.call
+			<< ", \"other\": " << stats.other
+			<< ", \"loops\": " << stats.loops
+			<< ", \"max_loop_depth\": " << stats.maxLoopDepth
+			<< ", \"unroll_hints\": " << stats.unrollHints
+			<< ", \"function_variables\": " << stats.functionVariables
+			<< ", \"peak_live_scalars\": " << stats.peakLiveScalars
+			<< ", \"id_bound\": " << stats.bound
+			<< ", \"decorations\": {";
+		bool first = true;
+		for(const auto& decoration : stats.decorations){
+			out << (first ? "" : ", ") << jsonString(decoration.first) << ": " << decoration.second;
+			first = false;
+		}
+		out << "}}";
+	}
+
+#endif
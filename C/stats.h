@@ -0,0 +1,465 @@
+#ifndef AULE_STATS_H
+#define AULE_STATS_H
+
+// Streaming summaries of frame times. Memory is bounded however long the
+// run, so soak tests of millions of frames don't need every sample kept.
+
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+#define HISTOGRAM_MIN 0.001 // Smallest value told apart, in microseconds
+#define HISTOGRAM_MAX 1.0e8 // Anything slower than 100 s lands in the last bucket
+#define HISTOGRAM_PRECISION 0.001 // Relative width of each bucket
+#define RESERVOIR_SIZE 10000 // Samples kept for the bootstrap
+#define BOOTSTRAP_RESAMPLES 1000
+#define STEADY_STATE_TOLERANCE 0.02 // Consecutive window medians this close mean the clocks have settled
+#define COMPARE_SAMPLES 20000 // Most samples of each side the rank test and bootstrap look at
+
+	// HDR-style histogram: logarithmic buckets, so every value is kept to the
+	// same relative precision with a fixed number of counters.
+	class Histogram {
+	public:
+		Histogram() : counts(bucketFor(HISTOGRAM_MAX) + 1, 0) {}
+
+		void clear(){
+			std::fill(counts.begin(), counts.end(), 0);
+			total = 0;
+		}
+
+		void add(double value){
+			counts[bucketFor(value)]++;
+			total++;
+		}
+
+		// Value below which the fraction q of samples fall, to bucket precision.
+		double quantile(double q) const {
+			if(total == 0){
+				return std::numeric_limits<double>::quiet_NaN();
+			}
+			uint64_t rank = static_cast<uint64_t>(std::ceil(q * total));
+			rank = std::max<uint64_t>(rank, 1);
+			uint64_t seen = 0;
+			for(size_t i = 0; i < counts.size(); i++){
+				if(seen + counts[i] >= rank){
+					// Spread the bucket's samples evenly across it.
+					double position = (rank - seen - 0.5) / counts[i];
+					return bucketLow(i) + position * (bucketLow(i + 1) - bucketLow(i));
+				}
+				seen += counts[i];
+			}
+			return HISTOGRAM_MAX;
+		}
+
+		uint64_t size() const { return total; }
+
+	private:
+		std::vector<uint64_t> counts;
+		uint64_t total = 0;
+
+		static size_t bucketFor(double value){
+			if(!(value > HISTOGRAM_MIN)){
+				return 0;
+			}
+			double bucket = std::log(std::min(value, HISTOGRAM_MAX) / HISTOGRAM_MIN) / std::log1p(HISTOGRAM_PRECISION);
+			return static_cast<size_t>(bucket) + 1;
+		}
+
+		// Smallest value that lands in the bucket
+		static double bucketLow(size_t bucket){
+			if(bucket == 0){
+				return 0.0;
+			}
+			return HISTOGRAM_MIN * std::pow(1.0 + HISTOGRAM_PRECISION, bucket - 1.0);
+		}
+	};
+
+	struct Summary {
+		uint64_t count = 0;
+		double mean = 0.0;
+		double stddev = 0.0;
+		double min = 0.0;
+		double max = 0.0;
+		double median = 0.0;
+		double p90 = 0.0;
+		double p99 = 0.0;
+		double p999 = 0.0;
+		double medianLow = 0.0; // 95% bootstrap confidence interval of the median
+		double medianHigh = 0.0;
+	};
+
+	// Everything we want to know about one measurement, fed a sample at a time.
+	// The first warmup samples are thrown away.
+	class SampleStats {
+	public:
+		SampleStats() : reservoir(RESERVOIR_SIZE), random(12345) {}
+
+		void reset(uint64_t warmupSamples){
+			warmup = warmupSamples;
+			seen = 0;
+			histogram.clear();
+			count = 0;
+			mean = 0.0;
+			m2 = 0.0;
+			min = std::numeric_limits<double>::max();
+			max = std::numeric_limits<double>::lowest();
+			random.seed(12345);
+		}
+
+		void add(double value){
+			if(seen++ < warmup){
+				return;
+			}
+
+			histogram.add(value);
+
+			// Welford's running mean and variance
+			count++;
+			double delta = value - mean;
+			mean += delta / count;
+			m2 += delta * (value - mean);
+			min = std::min(min, value);
+			max = std::max(max, value);
+
+			// Reservoir sampling keeps a uniform sample of everything so far.
+			if(count <= reservoir.size()){
+				reservoir[count - 1] = value;
+			} else {
+				uint64_t slot = std::uniform_int_distribution<uint64_t>(0, count - 1)(random);
+				if(slot < reservoir.size()){
+					reservoir[slot] = value;
+				}
+			}
+		}
+
+		uint64_t size() const { return count; }
+		const Histogram& distribution() const { return histogram; }
+
+		// Width of the median's 95% confidence interval relative to the median.
+		// Taken from the order statistics rather than the bootstrap, so it is
+		// cheap enough to ask while the run is going.
+		double relativeMedianCi() const {
+			if(count < 2){
+				return std::numeric_limits<double>::infinity();
+			}
+			double spread = 0.98 / std::sqrt(static_cast<double>(count));
+			double low = histogram.quantile(std::max(0.5 - spread, 0.0));
+			double high = histogram.quantile(std::min(0.5 + spread, 1.0));
+			return (high - low) / histogram.quantile(0.5);
+		}
+
+		Summary summarize(){
+			Summary summary;
+			summary.count = count;
+			if(count == 0){
+				return summary;
+			}
+
+			summary.mean = mean;
+			summary.stddev = count > 1 ? std::sqrt(m2 / (count - 1)) : 0.0;
+			summary.min = min;
+			summary.max = max;
+			summary.median = histogram.quantile(0.5);
+			summary.p90 = histogram.quantile(0.9);
+			summary.p99 = histogram.quantile(0.99);
+			summary.p999 = histogram.quantile(0.999);
+
+			// Bootstrap the median from the reservoir.
+			size_t n = std::min<uint64_t>(count, reservoir.size());
+			std::vector<double> resample(n);
+			std::vector<double> medians(BOOTSTRAP_RESAMPLES);
+			std::uniform_int_distribution<size_t> pick(0, n - 1);
+			for(double& median : medians){
+				for(double& value : resample){
+					value = reservoir[pick(random)];
+				}
+				std::nth_element(resample.begin(), resample.begin() + n / 2, resample.end());
+				median = resample[n / 2];
+			}
+			std::sort(medians.begin(), medians.end());
+			summary.medianLow = medians[static_cast<size_t>(0.025 * (medians.size() - 1))];
+			summary.medianHigh = medians[static_cast<size_t>(0.975 * (medians.size() - 1))];
+
+			return summary;
+		}
+
+	private:
+		uint64_t warmup = 0;
+		uint64_t seen = 0;
+		Histogram histogram;
+		uint64_t count = 0;
+		double mean = 0.0;
+		double m2 = 0.0;
+		double min = std::numeric_limits<double>::max();
+		double max = std::numeric_limits<double>::lowest();
+		std::vector<double> reservoir;
+		std::mt19937_64 random;
+	};
+
+	// Least squares straight line through the points, y = intercept + slope * x.
+	struct LinearFit {
+		double intercept = 0.0;
+		double slope = 0.0;
+		double r2 = 0.0; // Fraction of the variance in y the line explains
+	};
+
+	inline LinearFit fitLine(const std::vector<double>& x, const std::vector<double>& y){
+		double n = x.size();
+		double meanX = 0.0;
+		double meanY = 0.0;
+		for(size_t i = 0; i < x.size(); i++){
+			meanX += x[i] / n;
+			meanY += y[i] / n;
+		}
+
+		double sxx = 0.0;
+		double sxy = 0.0;
+		double syy = 0.0;
+		for(size_t i = 0; i < x.size(); i++){
+			sxx += (x[i] - meanX) * (x[i] - meanX);
+			sxy += (x[i] - meanX) * (y[i] - meanY);
+			syy += (y[i] - meanY) * (y[i] - meanY);
+		}
+
+		LinearFit fit;
+		fit.slope = sxy / sxx;
+		fit.intercept = meanY - fit.slope * meanX;
+		fit.r2 = syy > 0.0 ? sxy * sxy / (sxx * syy) : 1.0;
+		return fit;
+	}
+
+	// Whether b is slower than a: Mann-Whitney U on the ranks, and a bootstrap
+	// of the difference of the medians for how much.
+	struct Comparison {
+		uint64_t countA = 0;
+		uint64_t countB = 0;
+		double medianA = 0.0;
+		double medianB = 0.0;
+		double difference = 0.0; // medianB - medianA
+		double differenceLow = 0.0; // 95% bootstrap confidence interval of the difference
+		double differenceHigh = 0.0;
+		double z = 0.0; // Normal approximation of U, positive when b tends to be slower
+		double p = 1.0; // Two sided
+		double superiority = 0.5; // Chance a sample of b is slower than one of a, ties counting half
+		double rankBiserial = 0.0; // The same effect on -1..1, 0 for none
+	};
+
+	// Evenly spaced samples, so long runs don't make the test slow. Samples
+	// taken in order keep any drift in the run in both sides alike.
+	inline std::vector<double> thinSamples(const std::vector<double>& samples, size_t limit){
+		if(samples.size() <= limit){
+			return samples;
+		}
+		std::vector<double> thinned(limit);
+		for(size_t i = 0; i < limit; i++){
+			thinned[i] = samples[i * samples.size() / limit];
+		}
+		return thinned;
+	}
+
+	inline double medianOf(std::vector<double> values){
+		std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+		return values[values.size() / 2];
+	}
+
+	inline Comparison compareSamples(const std::vector<double>& allA, const std::vector<double>& allB){
+		Comparison comparison;
+		std::vector<double> a = thinSamples(allA, COMPARE_SAMPLES);
+		std::vector<double> b = thinSamples(allB, COMPARE_SAMPLES);
+		comparison.countA = a.size();
+		comparison.countB = b.size();
+		if(a.empty() || b.empty()){
+			return comparison;
+		}
+		comparison.medianA = medianOf(a);
+		comparison.medianB = medianOf(b);
+		comparison.difference = comparison.medianB - comparison.medianA;
+
+		// Ranks of everything together, ties sharing their average rank.
+		std::vector<std::pair<double, bool>> pooled; // Value, and whether it came from b
+		pooled.reserve(a.size() + b.size());
+		for(double value : a){
+			pooled.push_back({value, false});
+		}
+		for(double value : b){
+			pooled.push_back({value, true});
+		}
+		std::sort(pooled.begin(), pooled.end());
+		double n = pooled.size();
+		double rankSumB = 0.0;
+		double ties = 0.0; // Sum of t^3 - t over groups of t tied values
+		for(size_t i = 0; i < pooled.size(); ){
+			size_t j = i;
+			while(j < pooled.size() && pooled[j].first == pooled[i].first){
+				j++;
+			}
+			double rank = (i + 1 + j) / 2.0;
+			for(size_t k = i; k < j; k++){
+				if(pooled[k].second){
+					rankSumB += rank;
+				}
+			}
+			double t = j - i;
+			ties += t * t * t - t;
+			i = j;
+		}
+
+		double na = a.size();
+		double nb = b.size();
+		double u = rankSumB - nb * (nb + 1) / 2;
+		double variance = na * nb / 12.0 * ((n + 1) - ties / (n * (n - 1)));
+		if(variance > 0.0){
+			// Half a rank of continuity correction towards no difference
+			double shift = u - na * nb / 2;
+			shift -= shift > 0.0 ? 0.5 : shift < 0.0 ? -0.5 : 0.0;
+			comparison.z = shift / std::sqrt(variance);
+			comparison.p = std::erfc(std::abs(comparison.z) / std::sqrt(2.0));
+		}
+		comparison.superiority = u / (na * nb);
+		comparison.rankBiserial = 2.0 * comparison.superiority - 1.0;
+
+		// Resample both sides for the spread of the difference.
+		std::mt19937_64 random(12345);
+		std::uniform_int_distribution<size_t> pickA(0, a.size() - 1);
+		std::uniform_int_distribution<size_t> pickB(0, b.size() - 1);
+		std::vector<double> resampleA(a.size());
+		std::vector<double> resampleB(b.size());
+		std::vector<double> differences(BOOTSTRAP_RESAMPLES);
+		for(double& difference : differences){
+			for(double& value : resampleA){
+				value = a[pickA(random)];
+			}
+			for(double& value : resampleB){
+				value = b[pickB(random)];
+			}
+			difference = medianOf(resampleB) - medianOf(resampleA);
+		}
+		std::sort(differences.begin(), differences.end());
+		comparison.differenceLow = differences[static_cast<size_t>(0.025 * (differences.size() - 1))];
+		comparison.differenceHigh = differences[static_cast<size_t>(0.975 * (differences.size() - 1))];
+
+		return comparison;
+	}
+
+	// Spots the end of the clock or thermal ramp at the start of a run: the
+	// samples are split into windows, and once a window's median is within
+	// tolerance of the one before, the measurement has settled.
+	class SteadyStateDetector {
+	public:
+		void reset(uint32_t windowSize){
+			window.assign(windowSize, 0.0);
+			filled = 0;
+			previousMedian = -1.0;
+			steady = false;
+		}
+
+		// True from the sample that completes the first settled window on.
+		bool add(double value){
+			if(steady){
+				return true;
+			}
+
+			window[filled++] = value;
+			if(filled < window.size()){
+				return false;
+			}
+			filled = 0;
+
+			std::nth_element(window.begin(), window.begin() + window.size() / 2, window.end());
+			double median = window[window.size() / 2];
+			if(previousMedian >= 0.0 && std::abs(median - previousMedian) <= STEADY_STATE_TOLERANCE * previousMedian){
+				steady = true;
+			}
+			previousMedian = median;
+			return steady;
+		}
+
+		bool isSteady() const { return steady; }
+
+	private:
+		std::vector<double> window;
+		size_t filled = 0;
+		double previousMedian = -1.0;
+		bool steady = false;
+	};
+
+	// The same summary in other units, per pass rather than per frame say.
+	inline Summary scaleSummary(Summary summary, double factor){
+		summary.mean *= factor;
+		summary.stddev *= factor;
+		summary.min *= factor;
+		summary.max *= factor;
+		summary.median *= factor;
+		summary.p90 *= factor;
+		summary.p99 *= factor;
+		summary.p999 *= factor;
+		summary.medianLow *= factor;
+		summary.medianHigh *= factor;
+		return summary;
+	}
+
+	inline void printSummary(std::ostream& out, const std::string& label, const Summary& summary){
+		if(summary.count == 0){
+			out << "  " << label << ": no samples after warmup" << std::endl;
+			return;
+		}
+		out << "  " << label << ": mean " << summary.mean << ", median " << summary.median
+			<< " [" << summary.medianLow << ", " << summary.medianHigh << "]"
+			<< ", p90 " << summary.p90 << ", p99 " << summary.p99 << ", p99.9 " << summary.p999
+			<< ", stddev " << summary.stddev << ", min " << summary.min << ", max " << summary.max
+			<< " (" << summary.count << " frames)" << std::endl;
+	}
+
+	inline std::string jsonString(const std::string& text){
+		std::string quoted = "\"";
+		for(char c : text){
+			if(c == '"' || c == '\\'){
+				quoted += '\\';
+				quoted += c;
+			} else if(c == '\n'){
+				quoted += "\\n";
+			} else if(c == '\t'){
+				quoted += "\\t";
+			} else if(static_cast<unsigned char>(c) < 0x20){
+				// Other control characters, as drivers and file names may have
+				char escaped[8];
+				snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+				quoted += escaped;
+			} else {
+				quoted += c;
+			}
+		}
+		return quoted + "\"";
+	}
+
+	// JSON has no infinity or NaN, so those are null.
+	inline std::string jsonNumber(double value){
+		if(!std::isfinite(value)){
+			return "null";
+		}
+		std::ostringstream text;
+		text << value;
+		return text.str();
+	}
+
+	inline void writeSummaryJson(std::ostream& out, const Summary& summary){
+		out << "{\"count\": " << summary.count
+			<< ", \"mean\": " << summary.mean
+			<< ", \"median\": " << summary.median
+			<< ", \"median_ci95\": [" << summary.medianLow << ", " << summary.medianHigh << "]"
+			<< ", \"p90\": " << summary.p90
+			<< ", \"p99\": " << summary.p99
+			<< ", \"p99_9\": " << summary.p999
+			<< ", \"stddev\": " << summary.stddev
+			<< ", \"min\": " << summary.min
+			<< ", \"max\": " << summary.max << "}";
+	}
+
+#endif
@@ -4,6 +4,7 @@
 #extension GL_ARB_separate_shader_objects : enable
 
 layout(location = 0) out vec3 fragColor;
+layout(location = 1) flat out int layer; // Which pass this is when the passes are instanced
 
 vec2 positions[6] = vec2[](
     vec2(-1.0, -1.0),
@@ -26,6 +27,7 @@ vec3 colors[6] = vec3[](
 void main() {
     gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
     fragColor = colors[gl_VertexIndex];
+    layer = gl_InstanceIndex;
 }
 
 